@@ -0,0 +1,555 @@
+#pragma once
+
+#include "graph.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сжатия (contraction hierarchies). При построении вершины по очереди «сжимаются»:
+// вершина удаляется из графа, а пути через неё, для которых нет обходного пути-свидетеля
+// не длиннее, заменяются рёбрами-сокращениями. Запрос — встречный поиск Дейкстры, который
+// идёт только по рёбрам к вершинам, сжатым позже. Сокращения раскрываются в исходные рёбра.
+//
+// Вершины сжимаются раундами: в раунд попадают вершины, чей приоритет меньше, чем у всех
+// несжатых соседей. Такие вершины не смежны, поэтому сокращения для них ищутся параллельно.
+template <typename Weight>
+class ContractionHierarchy {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    struct Route {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    // thread_count — число потоков предрасчёта, 0 — по числу ядер
+    explicit ContractionHierarchy(const Graph& graph, size_t thread_count = 1);
+
+    std::optional<Route> BuildRoute(VertexId from, VertexId to) const;
+
+    size_t GetShortcutCount() const {
+        return arcs_.size() - original_arc_count_;
+    }
+
+private:
+    using ArcId = uint32_t;
+    static constexpr ArcId NO_ARC = std::numeric_limits<ArcId>::max();
+    static constexpr Weight ZERO_WEIGHT{};
+    // Предел числа вершин, просматриваемых поиском свидетеля. Если его не хватило,
+    // добавляется сокращение — лишнее, но не нарушающее корректность. Для оценки
+    // приоритета, которая пересчитывается часто, хватает более грубого поиска
+    static constexpr size_t WITNESS_SETTLED_LIMIT = 500;
+    static constexpr size_t PRIORITY_SETTLED_LIMIT = 50;
+    // Средняя исходящая степень несжатых вершин, начиная с которой они считаются плотным ядром
+    static constexpr size_t CORE_AVERAGE_DEGREE = 16;
+
+    // Ребро иерархии: исходное ребро графа (edge_id) либо сокращение first + second
+    struct Arc {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId edge_id;
+        ArcId first = NO_ARC;
+        ArcId second = NO_ARC;
+    };
+
+    struct Shortcut {
+        ArcId first;
+        ArcId second;
+        Weight weight;
+    };
+
+    // Локальный поиск Дейкстры для проверки свидетелей. Буферы переиспользуются между
+    // вызовами, отметки о посещении сбрасываются сменой номера поиска
+    class WitnessSearch {
+    public:
+        explicit WitnessSearch(size_t vertex_count)
+            : weights_(vertex_count)
+            , stamps_(vertex_count, 0)
+            , target_stamps_(vertex_count, 0) {
+        }
+
+        // Ищет пути от source до targets не длиннее limit. Поиск заканчивается, когда все цели
+        // извлечены из очереди: найденные веса — длины настоящих путей, их достаточно для проверки
+        template <typename IsBlocked>
+        void Run(const ContractionHierarchy& hierarchy, VertexId source, const std::vector<VertexId>& targets,
+                 Weight limit, size_t settled_limit, IsBlocked is_blocked) {
+            NextStamp();
+            for (const VertexId target : targets) {
+                target_stamps_[target] = stamp_;
+            }
+            size_t targets_left = targets.size();
+            queue_ = {};
+            SetWeight(source, ZERO_WEIGHT);
+            queue_.emplace(ZERO_WEIGHT, source);
+            size_t settled = 0;
+            while (!queue_.empty() && settled < settled_limit && targets_left > 0) {
+                const auto [weight, vertex] = queue_.top();
+                queue_.pop();
+                if (weights_[vertex] < weight) {
+                    continue;
+                }
+                if (limit < weight) {
+                    break;
+                }
+                ++settled;
+                if (target_stamps_[vertex] == stamp_) {
+                    target_stamps_[vertex] = 0;
+                    --targets_left;
+                }
+                for (const ArcId arc_id : hierarchy.out_arcs_[vertex]) {
+                    const Arc& arc = hierarchy.arcs_[arc_id];
+                    if (hierarchy.contracted_[arc.to] || is_blocked(arc.to)) {
+                        continue;
+                    }
+                    const Weight candidate_weight = weight + arc.weight;
+                    if (!GetWeight(arc.to) || candidate_weight < weights_[arc.to]) {
+                        SetWeight(arc.to, candidate_weight);
+                        queue_.emplace(candidate_weight, arc.to);
+                    }
+                }
+            }
+        }
+
+        std::optional<Weight> GetWeight(VertexId vertex) const {
+            if (stamps_[vertex] != stamp_) {
+                return std::nullopt;
+            }
+            return weights_[vertex];
+        }
+
+    private:
+        void NextStamp() {
+            if (++stamp_ == 0) {
+                std::fill(stamps_.begin(), stamps_.end(), 0);
+                std::fill(target_stamps_.begin(), target_stamps_.end(), 0);
+                stamp_ = 1;
+            }
+        }
+
+        void SetWeight(VertexId vertex, Weight weight) {
+            weights_[vertex] = weight;
+            stamps_[vertex] = stamp_;
+        }
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::vector<Weight> weights_;
+        std::vector<uint32_t> stamps_;
+        std::vector<uint32_t> target_stamps_;
+        uint32_t stamp_ = 0;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue_;
+    };
+
+    void AddArc(const Arc& arc);
+    template <typename IsBlocked>
+    void FindShortcuts(VertexId vertex, WitnessSearch& search, size_t settled_limit, IsBlocked is_blocked,
+                       std::vector<Shortcut>& shortcuts) const;
+    int64_t ComputePriority(VertexId vertex, WitnessSearch& search) const;
+    bool HasLowerPriority(VertexId lhs, VertexId rhs) const;
+    bool IsLocalMinimum(VertexId vertex) const;
+    bool IsDenseCore(const std::vector<VertexId>& remaining) const;
+    void Contract(VertexId vertex, const std::vector<Shortcut>& shortcuts, std::vector<VertexId>& touched);
+    void BuildUpwardGraph();
+    // Дописывает в arcs исходные дуги, которые заменяет дуга arc_id
+    void UnpackArc(ArcId arc_id, std::vector<ArcId>& arcs) const;
+
+    std::vector<Arc> arcs_;
+    size_t original_arc_count_ = 0;
+
+    // Состояние на время построения
+    std::vector<std::vector<ArcId>> out_arcs_;
+    std::vector<std::vector<ArcId>> in_arcs_;
+    std::vector<bool> contracted_;
+    std::vector<bool> in_round_;
+    std::vector<int64_t> priorities_;
+    std::vector<int64_t> deleted_neighbors_;
+    // Рёбра к вершинам, сжатым позже, собранные в момент сжатия вершины
+    std::vector<std::vector<ArcId>> upward_out_lists_;
+    std::vector<std::vector<ArcId>> upward_in_lists_;
+
+    // Граф запросов в форме CSR: upward_out_ — рёбра из вершины вверх для прямого поиска,
+    // upward_in_ — рёбра, входящие в вершину сверху, для обратного поиска
+    std::vector<size_t> upward_out_offsets_;
+    std::vector<ArcId> upward_out_;
+    std::vector<size_t> upward_in_offsets_;
+    std::vector<ArcId> upward_in_;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, size_t thread_count) {
+    const size_t vertex_count = graph.GetVertexCount();
+    thread_count = parallel::ResolveThreadCount(thread_count);
+
+    out_arcs_.resize(vertex_count);
+    in_arcs_.resize(vertex_count);
+    contracted_.assign(vertex_count, false);
+    in_round_.assign(vertex_count, false);
+    priorities_.assign(vertex_count, 0);
+    deleted_neighbors_.assign(vertex_count, 0);
+    upward_out_lists_.resize(vertex_count);
+    upward_in_lists_.resize(vertex_count);
+
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        if (edge.from != edge.to) {
+            AddArc(Arc{edge.from, edge.to, edge.weight, edge_id});
+        }
+    }
+    original_arc_count_ = arcs_.size();
+
+    std::vector<WitnessSearch> searches(thread_count, WitnessSearch(vertex_count));
+    parallel::ForEachIndex(vertex_count, thread_count, [&](size_t vertex, size_t worker) {
+        priorities_[vertex] = ComputePriority(vertex, searches[worker]);
+    });
+
+    std::vector<VertexId> remaining(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        remaining[vertex] = vertex;
+    }
+    std::vector<VertexId> round;
+    std::vector<std::vector<Shortcut>> shortcuts;
+    std::vector<VertexId> touched;
+    while (!remaining.empty()) {
+        if (IsDenseCore(remaining)) {
+            // Оставшееся ядро не сжимается: его рёбра доступны поиску в обе стороны
+            for (const VertexId vertex : remaining) {
+                upward_out_lists_[vertex] = out_arcs_[vertex];
+                upward_in_lists_[vertex] = in_arcs_[vertex];
+            }
+            break;
+        }
+        round.clear();
+        for (const VertexId vertex : remaining) {
+            if (IsLocalMinimum(vertex)) {
+                round.push_back(vertex);
+                in_round_[vertex] = true;
+            }
+        }
+
+        // Свидетели не должны проходить через вершины текущего раунда: они исчезнут одновременно
+        shortcuts.assign(round.size(), {});
+        parallel::ForEachIndex(round.size(), thread_count, [&](size_t index, size_t worker) {
+            FindShortcuts(round[index], searches[worker], WITNESS_SETTLED_LIMIT,
+                          [this](VertexId vertex) { return static_cast<bool>(in_round_[vertex]); },
+                          shortcuts[index]);
+        });
+
+        touched.clear();
+        for (size_t index = 0; index < round.size(); ++index) {
+            Contract(round[index], shortcuts[index], touched);
+            in_round_[round[index]] = false;
+        }
+
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        for (const VertexId vertex : touched) {
+            auto is_dead = [this](ArcId arc_id) {
+                return contracted_[arcs_[arc_id].from] || contracted_[arcs_[arc_id].to];
+            };
+            std::erase_if(out_arcs_[vertex], is_dead);
+            std::erase_if(in_arcs_[vertex], is_dead);
+        }
+        parallel::ForEachIndex(touched.size(), thread_count, [&](size_t index, size_t worker) {
+            priorities_[touched[index]] = ComputePriority(touched[index], searches[worker]);
+        });
+
+        std::erase_if(remaining, [this](VertexId vertex) { return static_cast<bool>(contracted_[vertex]); });
+    }
+
+    BuildUpwardGraph();
+
+    out_arcs_ = {};
+    in_arcs_ = {};
+    contracted_ = {};
+    in_round_ = {};
+    priorities_ = {};
+    deleted_neighbors_ = {};
+    upward_out_lists_ = {};
+    upward_in_lists_ = {};
+}
+
+// Добавляет ребро; из параллельных рёбер между парой вершин остаётся самое лёгкое
+template <typename Weight>
+void ContractionHierarchy<Weight>::AddArc(const Arc& arc) {
+    for (ArcId& arc_id : out_arcs_[arc.from]) {
+        if (arcs_[arc_id].to != arc.to) {
+            continue;
+        }
+        if (!(arc.weight < arcs_[arc_id].weight)) {
+            return;
+        }
+        const ArcId replaced_id = arc_id;
+        arc_id = static_cast<ArcId>(arcs_.size());
+        std::replace(in_arcs_[arc.to].begin(), in_arcs_[arc.to].end(), replaced_id, arc_id);
+        arcs_.push_back(arc);
+        return;
+    }
+    if (arcs_.size() >= NO_ARC) {
+        throw std::length_error("Too many arcs in contraction hierarchy");
+    }
+    const ArcId arc_id = static_cast<ArcId>(arcs_.size());
+    arcs_.push_back(arc);
+    out_arcs_[arc.from].push_back(arc_id);
+    in_arcs_[arc.to].push_back(arc_id);
+}
+
+template <typename Weight>
+template <typename IsBlocked>
+void ContractionHierarchy<Weight>::FindShortcuts(VertexId vertex, WitnessSearch& search, size_t settled_limit,
+                                                 IsBlocked is_blocked, std::vector<Shortcut>& shortcuts) const {
+    std::vector<VertexId> targets;
+    for (const ArcId in_id : in_arcs_[vertex]) {
+        const Arc& in_arc = arcs_[in_id];
+        if (contracted_[in_arc.from]) {
+            continue;
+        }
+
+        targets.clear();
+        Weight limit = ZERO_WEIGHT;
+        for (const ArcId out_id : out_arcs_[vertex]) {
+            const Arc& out_arc = arcs_[out_id];
+            if (contracted_[out_arc.to] || out_arc.to == in_arc.from) {
+                continue;
+            }
+            targets.push_back(out_arc.to);
+            limit = std::max(limit, in_arc.weight + out_arc.weight);
+        }
+        if (targets.empty()) {
+            continue;
+        }
+
+        search.Run(*this, in_arc.from, targets, limit, settled_limit, [vertex, &is_blocked](VertexId other) {
+            return other == vertex || is_blocked(other);
+        });
+        for (const ArcId out_id : out_arcs_[vertex]) {
+            const Arc& out_arc = arcs_[out_id];
+            if (contracted_[out_arc.to] || out_arc.to == in_arc.from) {
+                continue;
+            }
+            const Weight weight = in_arc.weight + out_arc.weight;
+            const auto witness_weight = search.GetWeight(out_arc.to);
+            if (!witness_weight || weight < *witness_weight) {
+                shortcuts.push_back(Shortcut{in_id, out_id, weight});
+            }
+        }
+    }
+}
+
+// Приоритет — разность числа добавляемых сокращений и удаляемых рёбер плюс число уже
+// сжатых соседей: так сжатие идёт равномерно по графу, а не выедает одну область
+template <typename Weight>
+int64_t ContractionHierarchy<Weight>::ComputePriority(VertexId vertex, WitnessSearch& search) const {
+    std::vector<Shortcut> shortcuts;
+    FindShortcuts(vertex, search, PRIORITY_SETTLED_LIMIT, [](VertexId) { return false; }, shortcuts);
+    const int64_t removed_arcs = static_cast<int64_t>(in_arcs_[vertex].size() + out_arcs_[vertex].size());
+    return static_cast<int64_t>(shortcuts.size()) - removed_arcs + deleted_neighbors_[vertex];
+}
+
+template <typename Weight>
+bool ContractionHierarchy<Weight>::HasLowerPriority(VertexId lhs, VertexId rhs) const {
+    return std::pair{priorities_[lhs], lhs} < std::pair{priorities_[rhs], rhs};
+}
+
+template <typename Weight>
+bool ContractionHierarchy<Weight>::IsLocalMinimum(VertexId vertex) const {
+    for (const ArcId arc_id : out_arcs_[vertex]) {
+        if (!HasLowerPriority(vertex, arcs_[arc_id].to)) {
+            return false;
+        }
+    }
+    for (const ArcId arc_id : in_arcs_[vertex]) {
+        if (!HasLowerPriority(vertex, arcs_[arc_id].from)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Сжатие вершины стоит порядка квадрата её степени, а степени в плотном ядре транспортной сети
+// растут лавинообразно. Такое ядро выгоднее оставить несжатым: запрос просмотрит его целиком,
+// но ядро мало по сравнению со всем графом
+template <typename Weight>
+bool ContractionHierarchy<Weight>::IsDenseCore(const std::vector<VertexId>& remaining) const {
+    size_t arc_count = 0;
+    for (const VertexId vertex : remaining) {
+        arc_count += out_arcs_[vertex].size();
+    }
+    return arc_count >= CORE_AVERAGE_DEGREE * remaining.size();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Contract(VertexId vertex, const std::vector<Shortcut>& shortcuts,
+                                            std::vector<VertexId>& touched) {
+    // Все несжатые соседи будут сжаты позже — это и есть рёбра «вверх»
+    for (const ArcId arc_id : out_arcs_[vertex]) {
+        upward_out_lists_[vertex].push_back(arc_id);
+        touched.push_back(arcs_[arc_id].to);
+        ++deleted_neighbors_[arcs_[arc_id].to];
+    }
+    for (const ArcId arc_id : in_arcs_[vertex]) {
+        upward_in_lists_[vertex].push_back(arc_id);
+        touched.push_back(arcs_[arc_id].from);
+        ++deleted_neighbors_[arcs_[arc_id].from];
+    }
+    contracted_[vertex] = true;
+
+    for (const Shortcut& shortcut : shortcuts) {
+        AddArc(Arc{arcs_[shortcut.first].from, arcs_[shortcut.second].to, shortcut.weight,
+                   EdgeId{}, shortcut.first, shortcut.second});
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildUpwardGraph() {
+    auto flatten = [](const std::vector<std::vector<ArcId>>& lists,
+                      std::vector<size_t>& offsets, std::vector<ArcId>& arcs) {
+        offsets.assign(1, 0);
+        offsets.reserve(lists.size() + 1);
+        for (const auto& list : lists) {
+            arcs.insert(arcs.end(), list.begin(), list.end());
+            offsets.push_back(arcs.size());
+        }
+    };
+    flatten(upward_out_lists_, upward_out_offsets_, upward_out_);
+    flatten(upward_in_lists_, upward_in_offsets_, upward_in_);
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackArc(ArcId arc_id, std::vector<ArcId>& arcs) const {
+    std::vector<ArcId> stack{arc_id};
+    while (!stack.empty()) {
+        const ArcId id = stack.back();
+        const Arc& arc = arcs_[id];
+        stack.pop_back();
+        if (arc.first == NO_ARC) {
+            arcs.push_back(id);
+        } else {
+            stack.push_back(arc.second);
+            stack.push_back(arc.first);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::Route>
+ContractionHierarchy<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = upward_out_offsets_.size() - 1;
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return Route{ZERO_WEIGHT, {}};
+    }
+
+    struct Label {
+        Weight weight;
+        ArcId arc;
+    };
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+    // Индекс 0 — прямой поиск от from, 1 — обратный от to
+    std::vector<std::optional<Label>> labels[2] = {std::vector<std::optional<Label>>(vertex_count),
+                                                   std::vector<std::optional<Label>>(vertex_count)};
+    Queue queues[2];
+    const std::vector<size_t>* offsets[2] = {&upward_out_offsets_, &upward_in_offsets_};
+    const std::vector<ArcId>* upward_arcs[2] = {&upward_out_, &upward_in_};
+
+    labels[0][from] = Label{ZERO_WEIGHT, NO_ARC};
+    labels[1][to] = Label{ZERO_WEIGHT, NO_ARC};
+    queues[0].emplace(ZERO_WEIGHT, from);
+    queues[1].emplace(ZERO_WEIGHT, to);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    auto is_finished = [&](int side) {
+        return queues[side].empty() || (best_weight && !(queues[side].top().first < *best_weight));
+    };
+
+    while (!is_finished(0) || !is_finished(1)) {
+        const int side = is_finished(0) ? 1 : is_finished(1) ? 0 : (queues[0].top() < queues[1].top() ? 0 : 1);
+        const auto [weight, vertex] = queues[side].top();
+        queues[side].pop();
+        if (labels[side][vertex]->weight < weight) {
+            continue;
+        }
+        if (const auto& opposite = labels[1 - side][vertex]) {
+            const Weight total_weight = weight + opposite->weight;
+            if (!best_weight || total_weight < *best_weight) {
+                best_weight = total_weight;
+                meeting_vertex = vertex;
+            }
+        }
+        for (size_t index = (*offsets[side])[vertex]; index < (*offsets[side])[vertex + 1]; ++index) {
+            const ArcId arc_id = (*upward_arcs[side])[index];
+            const Arc& arc = arcs_[arc_id];
+            const VertexId next = side == 0 ? arc.to : arc.from;
+            const Weight candidate_weight = weight + arc.weight;
+            auto& label = labels[side][next];
+            if (!label || candidate_weight < label->weight) {
+                label = Label{candidate_weight, arc_id};
+                queues[side].emplace(candidate_weight, next);
+            }
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<ArcId> path;
+    for (VertexId vertex = meeting_vertex; labels[0][vertex]->arc != NO_ARC; vertex = arcs_[path.back()].from) {
+        path.push_back(labels[0][vertex]->arc);
+    }
+    std::reverse(path.begin(), path.end());
+    for (VertexId vertex = meeting_vertex; labels[1][vertex]->arc != NO_ARC; vertex = arcs_[path.back()].to) {
+        path.push_back(labels[1][vertex]->arc);
+    }
+
+    std::vector<ArcId> original_arcs;
+    for (const ArcId arc_id : path) {
+        UnpackArc(arc_id, original_arcs);
+    }
+
+    // При рёбрах нулевого веса распакованный путь может пройти вершину дважды. Цикл между
+    // проходами на кратчайшем пути весит 0, поэтому вырезается без изменения веса.
+    // path_position[v] — число дуг пути до вершины v
+    std::vector<ArcId> simple_path;
+    std::unordered_map<VertexId, size_t> path_position{{from, 0}};
+    for (const ArcId arc_id : original_arcs) {
+        const VertexId vertex = arcs_[arc_id].to;
+        if (const auto it = path_position.find(vertex); it != path_position.end()) {
+            const size_t position = it->second;
+            for (size_t index = position; index < simple_path.size(); ++index) {
+                path_position.erase(arcs_[simple_path[index]].to);
+            }
+            simple_path.resize(position);
+            continue;
+        }
+        simple_path.push_back(arc_id);
+        path_position[vertex] = simple_path.size();
+    }
+
+    std::vector<EdgeId> edges;
+    edges.reserve(simple_path.size());
+    for (const ArcId arc_id : simple_path) {
+        edges.push_back(arcs_[arc_id].edge_id);
+    }
+    return Route{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -1,20 +1,34 @@
 #pragma once
+#include <cstdint>
 #include <set>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 #include "geo.h"
 
 namespace domain {
-    
+    // Номера остановок и автобусов в справочнике: плотные, по порядку добавления
+    using StopId = uint32_t;
+    using BusId = uint32_t;
+
+    // Имена указывают в хранилище строк справочника
     struct Stop	{
-        std::string stop_name;
+        StopId id;
+        std::string_view stop_name;
         geo::Coordinates coordinates;
     };
     struct Bus {
+        BusId id;
         bool is_roundtrip;
-        std::string bus_name;
-        std::vector<Stop*> stops;
+        std::string_view bus_name;
+        // Срез общего массива остановок маршрутов справочника
+        std::span<const StopId> stops;
+        // Дорожные расстояния перегонов: distances[i] — от stops[i] до stops[i + 1]
+        std::span<const int> distances;
+        // Отправления рейсов с первой остановки в минутах от начала суток, по возрастанию; срез общего
+        // массива отправлений справочника. Пусто — расписания нет, автобус ходит постоянно с ожиданием bus_wait_time
+        std::span<const double> departures;
     };
 
     struct BusInfo {
@@ -29,7 +43,8 @@ namespace domain {
     struct StopInfo {
         bool exists;
         std::string_view name;
-        std::set<std::string_view> buses;
+        // Автобусы через остановку по возрастанию названий, срез индекса справочника
+        std::span<const BusId> buses;
     };
 
     struct BusComparator {
@@ -0,0 +1,69 @@
+#include "floyd_warshall.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FLOYD_WARSHALL_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace graph {
+
+namespace detail {
+
+namespace {
+
+void MinPlusRowScalar(const double* row_through, const uint32_t* prev_edges_through, double weight_through,
+                      double* row, uint32_t* prev_edges, size_t count) {
+    MinPlusRow<double>(row_through, prev_edges_through, weight_through, row, prev_edges, count);
+}
+
+#ifdef FLOYD_WARSHALL_HAS_AVX2
+// Четыре элемента за шаг. Маска улучшений сжимается из 64-битных полос в 32-битные
+// и тем же смешиванием переносит номера последних рёбер. Улучшения редки, поэтому
+// номера рёбер записываются только при ненулевой маске.
+__attribute__((target("avx2")))
+void MinPlusRowAvx2(const double* row_through, const uint32_t* prev_edges_through, double weight_through,
+                    double* row, uint32_t* prev_edges, size_t count) {
+    const __m256d through = _mm256_set1_pd(weight_through);
+    const __m256i even_lanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    size_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+        const __m256d candidate = _mm256_add_pd(through, _mm256_loadu_pd(row_through + index));
+        const __m256d current = _mm256_loadu_pd(row + index);
+        const __m256d improved = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+        if (_mm256_movemask_pd(improved) == 0) {
+            continue;
+        }
+        _mm256_storeu_pd(row + index, _mm256_blendv_pd(current, candidate, improved));
+        const __m128i mask = _mm256_castsi256_si128(
+            _mm256_permutevar8x32_epi32(_mm256_castpd_si256(improved), even_lanes));
+        const auto* source = reinterpret_cast<const __m128i*>(prev_edges_through + index);
+        auto* target = reinterpret_cast<__m128i*>(prev_edges + index);
+        _mm_storeu_si128(target, _mm_blendv_epi8(_mm_loadu_si128(target), _mm_loadu_si128(source), mask));
+    }
+    MinPlusRowScalar(row_through + index, prev_edges_through + index, weight_through, row + index,
+                     prev_edges + index, count - index);
+}
+#endif
+
+using MinPlusRowKernel = void (*)(const double*, const uint32_t*, double, double*, uint32_t*, size_t);
+
+MinPlusRowKernel SelectMinPlusRowKernel() {
+#ifdef FLOYD_WARSHALL_HAS_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return MinPlusRowAvx2;
+    }
+#endif
+    return MinPlusRowScalar;
+}
+
+}  // namespace
+
+void MinPlusRow(const double* row_through, const uint32_t* prev_edges_through, double weight_through,
+                double* row, uint32_t* prev_edges, size_t count) {
+    static const MinPlusRowKernel kernel = SelectMinPlusRowKernel();
+    kernel(row_through, prev_edges_through, weight_through, row, prev_edges, count);
+}
+
+}  // namespace detail
+
+}  // namespace graph
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace graph {
+
+namespace detail {
+
+// Обновление строки min-plus: row[j] = min(row[j], weight_through + row_through[j]).
+// При улучшении последнее ребро пути берётся из prev_edges_through[j].
+template <typename Weight>
+void MinPlusRow(const Weight* row_through, const uint32_t* prev_edges_through, Weight weight_through,
+                Weight* row, uint32_t* prev_edges, size_t count) {
+    for (size_t index = 0; index < count; ++index) {
+        const Weight candidate_weight = weight_through + row_through[index];
+        if (candidate_weight < row[index]) {
+            row[index] = candidate_weight;
+            prev_edges[index] = prev_edges_through[index];
+        }
+    }
+}
+
+// Для double ядро выбирается при запуске: AVX2, если процессор его поддерживает, иначе скалярное
+void MinPlusRow(const double* row_through, const uint32_t* prev_edges_through, double weight_through,
+                double* row, uint32_t* prev_edges, size_t count);
+
+}  // namespace detail
+
+// Блочный алгоритм Флойда — Уоршелла над плоской матрицей vertex_count x vertex_count.
+// weights[i * n + j] — вес пути i -> j (бесконечность, если пути нет), prev_edges — последнее ребро
+// этого пути. Матрица режется на квадратные блоки TILE_SIZE x TILE_SIZE. Для каждой полосы
+// промежуточных вершин сначала считается диагональный блок, затем блоки её строки и столбца,
+// затем все остальные. Блоки внутри второй и третьей фаз независимы и считаются параллельно,
+// а рабочий набор одного блока помещается в кэш.
+template <typename Weight>
+class BlockedFloydWarshall {
+public:
+    static constexpr size_t TILE_SIZE = 64;
+
+    BlockedFloydWarshall(Weight* weights, uint32_t* prev_edges, size_t vertex_count)
+        : weights_(weights)
+        , prev_edges_(prev_edges)
+        , vertex_count_(vertex_count)
+        , tile_count_((vertex_count + TILE_SIZE - 1) / TILE_SIZE) {
+    }
+
+    void Run(size_t thread_count) {
+        for (size_t tile_through = 0; tile_through < tile_count_; ++tile_through) {
+            RelaxTile(tile_through, tile_through, tile_through);
+
+            const size_t other_count = tile_count_ - 1;
+            parallel::ForEachIndex(2 * other_count, thread_count, [&](size_t index, size_t) {
+                size_t other = index % other_count;
+                other += other >= tile_through ? 1 : 0;
+                if (index < other_count) {
+                    RelaxTile(tile_through, other, tile_through);
+                } else {
+                    RelaxTile(other, tile_through, tile_through);
+                }
+            });
+
+            // Блоки одной строки обрабатываются одним потоком подряд: общий для них блок
+            // (tile_row, tile_through) остаётся в кэше
+            parallel::ForEachIndex(other_count, thread_count, [&](size_t index, size_t) {
+                const size_t tile_row = index + (index >= tile_through ? 1 : 0);
+                for (size_t tile_column = 0; tile_column < tile_count_; ++tile_column) {
+                    if (tile_column != tile_through) {
+                        RelaxTile(tile_row, tile_column, tile_through);
+                    }
+                }
+            });
+        }
+    }
+
+private:
+    // Релаксация блока (tile_row, tile_column) через вершины блока tile_through
+    void RelaxTile(size_t tile_row, size_t tile_column, size_t tile_through) {
+        const size_t row_begin = tile_row * TILE_SIZE;
+        const size_t row_end = std::min(row_begin + TILE_SIZE, vertex_count_);
+        const size_t column_begin = tile_column * TILE_SIZE;
+        const size_t column_count = std::min(column_begin + TILE_SIZE, vertex_count_) - column_begin;
+        const size_t through_begin = tile_through * TILE_SIZE;
+        const size_t through_end = std::min(through_begin + TILE_SIZE, vertex_count_);
+
+        for (size_t through = through_begin; through < through_end; ++through) {
+            const size_t through_offset = through * vertex_count_ + column_begin;
+            for (size_t row = row_begin; row < row_end; ++row) {
+                const Weight weight_through = weights_[row * vertex_count_ + through];
+                // Пути row -> through нет, через through ничего не улучшится
+                if (weight_through == INFINITE_WEIGHT) {
+                    continue;
+                }
+                const size_t row_offset = row * vertex_count_ + column_begin;
+                detail::MinPlusRow(weights_ + through_offset, prev_edges_ + through_offset, weight_through,
+                                   weights_ + row_offset, prev_edges_ + row_offset, column_count);
+            }
+        }
+    }
+
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+
+    Weight* weights_;
+    uint32_t* prev_edges_;
+    size_t vertex_count_;
+    size_t tile_count_;
+};
+
+}  // namespace graph
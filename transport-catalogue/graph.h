@@ -2,7 +2,11 @@
 
 #include "ranges.h"
 
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <span>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -17,43 +21,120 @@ struct Edge {
     Weight weight;
 };
 
+// Граф заполняется через AddEdge, затем замораживается вызовом Finalize. Замороженный граф
+// хранит исходящие рёбра в виде CSR: рёбра вершины v занимают позиции [offsets[v], offsets[v + 1])
+// общих массивов целей, весов и идентификаторов. Идентификаторы рёбер при заморозке не меняются.
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
-    using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using IncidentEdgesRange = ranges::Range<const uint32_t*>;
 
 public:
+    // Исходящие рёбра вершины: параллельные массивы одной длины
+    struct IncidentArcs {
+        std::span<const uint32_t> targets;
+        std::span<const Weight> weights;
+        std::span<const uint32_t> edge_ids;
+    };
+
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    void Finalize();
+    // Меняет вес ребра на месте, в том числе в замороженном графе
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
 
+    bool IsFinalized() const;
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    // Методы ниже доступны только после Finalize
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    IncidentArcs GetIncidentArcs(VertexId vertex) const;
 
 private:
+    void CheckFinalized() const;
+
+    size_t vertex_count_ = 0;
     std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_;
+    bool finalized_ = false;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> targets_;
+    std::vector<Weight> weights_;
+    std::vector<uint32_t> edge_ids_;
+    // Позиция ребра в массивах CSR, индекс — EdgeId
+    std::vector<uint32_t> edge_positions_;
 };
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+    : vertex_count_(vertex_count) {
+    if (vertex_count > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Too many vertices");
+    }
 }
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    if (finalized_) {
+        throw std::logic_error("Graph is finalized");
+    }
+    if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (edges_.size() == std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Too many edges");
+    }
     edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+    return edges_.size() - 1;
+}
+
+// Сортировка рёбер подсчётом по начальной вершине; внутри вершины сохраняется порядок добавления
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Finalize() {
+    if (finalized_) {
+        return;
+    }
+    offsets_.assign(vertex_count_ + 1, 0);
+    for (const auto& edge : edges_) {
+        ++offsets_[edge.from + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+        offsets_[vertex + 1] += offsets_[vertex];
+    }
+
+    targets_.resize(edges_.size());
+    weights_.resize(edges_.size());
+    edge_ids_.resize(edges_.size());
+    edge_positions_.resize(edges_.size());
+    std::vector<uint32_t> positions(offsets_.begin(), offsets_.end() - 1);
+    for (size_t edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const auto& edge = edges_[edge_id];
+        const uint32_t position = positions[edge.from]++;
+        targets_[position] = static_cast<uint32_t>(edge.to);
+        weights_[position] = edge.weight;
+        edge_ids_[position] = static_cast<uint32_t>(edge_id);
+        edge_positions_[edge_id] = position;
+    }
+    finalized_ = true;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    edges_.at(edge_id).weight = weight;
+    if (finalized_) {
+        weights_[edge_positions_[edge_id]] = weight;
+    }
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFinalized() const {
+    return finalized_;
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
 }
 
 template <typename Weight>
@@ -69,6 +150,30 @@ const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    const auto arcs = GetIncidentArcs(vertex);
+    return {arcs.edge_ids.data(), arcs.edge_ids.data() + arcs.edge_ids.size()};
+}
+
+template <typename Weight>
+typename DirectedWeightedGraph<Weight>::IncidentArcs
+DirectedWeightedGraph<Weight>::GetIncidentArcs(VertexId vertex) const {
+    CheckFinalized();
+    if (vertex >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const uint32_t begin = offsets_[vertex];
+    const uint32_t count = offsets_[vertex + 1] - begin;
+    return {
+        std::span<const uint32_t>(targets_.data() + begin, count),
+        std::span<const Weight>(weights_.data() + begin, count),
+        std::span<const uint32_t>(edge_ids_.data() + begin, count)
+    };
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::CheckFinalized() const {
+    if (!finalized_) {
+        throw std::logic_error("Graph is not finalized");
+    }
 }
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
@@ -1,335 +1,769 @@
 #include "json.h"
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JSON_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 namespace json {
 
 namespace {
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+// Разбор идёт в два этапа, как в simdjson. Первый этап блоками по 64 байта строит битовые маски
+// кавычек, обратных слешей, пробельных и структурных символов, по ним находит границы строк
+// и выписывает индекс: позиции структурных символов вне строк, открывающих и закрывающих
+// кавычек и начал чисел и литералов. Второй этап идёт по индексу и строит Document,
+// не просматривая пробелы и содержимое строк посимвольно.
+
+// Маски одного блока: бит i соответствует байту i
+struct BlockMasks {
+    uint64_t backslashes = 0;
+    uint64_t quotes = 0;
+    uint64_t whitespaces = 0;
+    // Символы { } [ ] : ,
+    uint64_t operators = 0;
+    uint64_t line_breaks = 0;
+};
+
+constexpr size_t BLOCK_SIZE = 64;
+
+BlockMasks ClassifyBlockScalar(const char* block) {
+    BlockMasks masks;
+    for (size_t index = 0; index < BLOCK_SIZE; ++index) {
+        const uint64_t bit = uint64_t{1} << index;
+        switch (block[index]) {
+            case '\\':
+                masks.backslashes |= bit;
+                break;
+            case '"':
+                masks.quotes |= bit;
+                break;
+            case '\n':
+            case '\r':
+                masks.line_breaks |= bit;
+                [[fallthrough]];
+            case ' ':
+            case '\t':
+                masks.whitespaces |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                masks.operators |= bit;
+                break;
+            default:
+                break;
+        }
+    }
+    return masks;
+}
+
+#ifdef JSON_HAS_AVX2
+// Сравнения по 32 байта, маски двух половин блока склеиваются в одно 64-битное число
+__attribute__((target("avx2")))
+uint64_t MatchAny(__m256i low, __m256i high, std::initializer_list<char> chars) {
+    __m256i low_matches = _mm256_setzero_si256();
+    __m256i high_matches = _mm256_setzero_si256();
+    for (const char c : chars) {
+        const __m256i value = _mm256_set1_epi8(c);
+        low_matches = _mm256_or_si256(low_matches, _mm256_cmpeq_epi8(low, value));
+        high_matches = _mm256_or_si256(high_matches, _mm256_cmpeq_epi8(high, value));
+    }
+    const auto low_mask = static_cast<uint32_t>(_mm256_movemask_epi8(low_matches));
+    const auto high_mask = static_cast<uint32_t>(_mm256_movemask_epi8(high_matches));
+    return uint64_t{low_mask} | uint64_t{high_mask} << 32;
+}
+
+__attribute__((target("avx2")))
+BlockMasks ClassifyBlockAvx2(const char* block) {
+    const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    BlockMasks masks;
+    masks.backslashes = MatchAny(low, high, {'\\'});
+    masks.quotes = MatchAny(low, high, {'"'});
+    masks.line_breaks = MatchAny(low, high, {'\n', '\r'});
+    masks.whitespaces = masks.line_breaks | MatchAny(low, high, {' ', '\t'});
+    masks.operators = MatchAny(low, high, {'{', '}', '[', ']', ':', ','});
+    return masks;
+}
+#endif
+
+using ClassifyBlockKernel = BlockMasks (*)(const char*);
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
+ClassifyBlockKernel SelectClassifyBlockKernel() {
+#ifdef JSON_HAS_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return ClassifyBlockAvx2;
     }
-    return s;
+#endif
+    return ClassifyBlockScalar;
 }
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+// Выбирается при первом разборе, detail::SetScanKernel может его заменить
+ClassifyBlockKernel& GetClassifyBlockKernel() {
+    static ClassifyBlockKernel kernel = SelectClassifyBlockKernel();
+    return kernel;
+}
+
+// Экранированные символы блока: второй, четвёртый и т.д. символ каждой серии обратных слешей
+// и символ сразу после серии нечётной длины. prev_escaped — экранирован ли первый байт
+// следующего блока.
+uint64_t FindEscaped(uint64_t backslashes, uint64_t& prev_escaped) {
+    constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+    backslashes &= ~prev_escaped;
+    const uint64_t follows_escape = backslashes << 1 | prev_escaped;
+    // Серии, начинающиеся на нечётном бите, сложением переносятся за свой конец
+    const uint64_t odd_sequence_starts = backslashes & ~EVEN_BITS & ~follows_escape;
+    uint64_t sequences_starting_on_even_bits = 0;
+    prev_escaped = __builtin_add_overflow(odd_sequence_starts, backslashes, &sequences_starting_on_even_bits);
+    const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+    return (EVEN_BITS ^ invert_mask) & follows_escape;
+}
+
+// Бит i результата — xor битов 0..i: единицы от открывающей кавычки до закрывающей (не включая её)
+uint64_t PrefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Первый этап идёт порциями по мере продвижения второго: индекс хранит позиции только
+// текущей порции, и его размер не зависит от размера документа
+class StructuralScanner {
+public:
+    // Размечает целые блоки data[0, size) и возвращает число размеченных байт. Позиции в index
+    // отсчитываются от начала ввода, data начинается с позиции offset. is_last — данных после
+    // data нет: неполный последний блок дополняется пробелами и размечается тоже.
+    // Начало числа или литерала, не закончившегося в размеченных блоках, откладывается до
+    // следующего вызова, чтобы второй этап всегда видел его конец
+    size_t Scan(const char* data, size_t size, size_t offset, bool is_last, std::vector<size_t>& index) {
+        const ClassifyBlockKernel classify_block = GetClassifyBlockKernel();
+        if (held_scalar_) {
+            index.push_back(*held_scalar_);
+            held_scalar_.reset();
+        }
+
+        size_t begin = 0;
+        for (; begin + BLOCK_SIZE <= size || (is_last && begin < size); begin += BLOCK_SIZE) {
+            BlockMasks masks;
+            if (size - begin >= BLOCK_SIZE) {
+                masks = classify_block(data + begin);
+            } else {
+                // Хвост дополняется пробелами до целого блока
+                std::array<char, BLOCK_SIZE> tail;
+                tail.fill(' ');
+                std::copy(data + begin, data + size, tail.begin());
+                masks = classify_block(tail.data());
+            }
+
+            const uint64_t quotes = masks.quotes & ~FindEscaped(masks.backslashes, prev_escaped_);
+            const uint64_t in_string = PrefixXor(quotes) ^ prev_in_string_;
+            prev_in_string_ = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+            if (masks.line_breaks & in_string) {
+                throw ParsingError("Unexpected end of line"s);
+            }
 
-    for (char c; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
+            const uint64_t scalars = ~(masks.whitespaces | masks.operators | quotes | in_string);
+            const uint64_t scalar_starts = scalars & ~(scalars << 1 | prev_scalar_);
+            prev_scalar_ = scalars >> 63;
+
+            for (uint64_t structurals = (masks.operators & ~in_string) | quotes | scalar_starts; structurals != 0;
+                 structurals &= structurals - 1) {
+                index.push_back(offset + begin + __builtin_ctzll(structurals));
+            }
+        }
+
+        if (is_last) {
+            if (prev_in_string_ != 0) {
+                throw ParsingError("String parsing error"s);
+            }
+            return size;
+        }
+        // Внутри числа или литерала нет структурных символов: последний в индексе — его начало
+        if (prev_scalar_ != 0 && !index.empty()) {
+            held_scalar_ = index.back();
+            index.pop_back();
         }
-        result.push_back(LoadNode(input));
+        return begin;
     }
-    if (!input) {
-        throw ParsingError("Array parsing error"s);
+
+private:
+    uint64_t prev_escaped_ = 0;
+    // Все единицы, если предыдущий блок закончился внутри строки
+    uint64_t prev_in_string_ = 0;
+    // Был ли последний байт предыдущего блока частью числа или литерала
+    uint64_t prev_scalar_ = 0;
+    std::optional<size_t> held_scalar_;
+};
+
+// Второй этап: чтение по структурному индексу. Строка занимает промежуток между двумя
+// соседними кавычками индекса, числа преобразуются через std::from_chars без промежуточных строк.
+// Построение Document и потоковый разбор отличаются только тем, что делают с прочитанным.
+// Поток читается порциями в окно: байты до последнего выданного символа индекса
+// выбрасываются, поэтому в памяти остаётся только ещё не разобранная часть ввода
+class TokenReader {
+public:
+    static constexpr size_t CHUNK_SIZE = 1024 * BLOCK_SIZE;
+
+    explicit TokenReader(std::string_view input)
+        : window_(input)
+        , input_end_(true) {
+    }
+
+    explicit TokenReader(std::istream& input)
+        : input_(&input) {
+    }
+
+protected:
+    // Позиция следующего символа индекса; конец ввода — ошибка с текстом context.
+    // Указатель действителен до следующего чтения индекса
+    const char* NextPosition(std::string_view context) {
+        if (!HasToken()) {
+            throw ParsingError(std::string(context));
+        }
+        last_position_ = index_[token_++];
+        return GetPointer(last_position_);
+    }
+
+    char NextToken(std::string_view context) {
+        return *NextPosition(context);
+    }
+
+    char PeekToken() {
+        return HasToken() ? *GetPointer(index_[token_]) : '\0';
     }
-    return Node(std::move(result));
-}
 
+    // После корневого значения во вводе допустимы только пробельные символы
+    void ExpectEnd() {
+        if (HasToken()) {
+            throw ParsingError("Unexpected data after JSON value"s);
+        }
+    }
+
+    void SkipToken() {
+        ++token_;
+    }
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            throw ParsingError("String parsing error");
+    // Читает строку, открывающая кавычка которой — последний выданный символ индекса.
+    // Строка без escape-последовательностей возвращается видом на окно ввода, иначе
+    // раскодируется в scratch. Вид действителен до следующего чтения индекса
+    std::string_view ReadString(std::string& scratch) {
+        const size_t quote = last_position_;
+        const char* end = NextPosition("String parsing error"sv);
+        const char* begin = GetPointer(quote) + 1;
+        const char* backslash = static_cast<const char*>(std::memchr(begin, '\\', end - begin));
+        if (backslash == nullptr) {
+            return std::string_view(begin, end - begin);
         }
-        const char ch = *it;
-        if (ch == '"') {
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
-                throw ParsingError("String parsing error");
+
+        scratch.assign(begin, backslash);
+        for (const char* pos = backslash; pos != end; ++pos) {
+            if (*pos != '\\') {
+                scratch.push_back(*pos);
+                continue;
             }
-            const char escaped_char = *(it);
+            // Обратный слеш внутри строки всегда экранирует следующий символ до закрывающей кавычки
+            const char escaped_char = *++pos;
             switch (escaped_char) {
                 case 'n':
-                    s.push_back('\n');
+                    scratch.push_back('\n');
                     break;
                 case 't':
-                    s.push_back('\t');
+                    scratch.push_back('\t');
                     break;
                 case 'r':
-                    s.push_back('\r');
+                    scratch.push_back('\r');
                     break;
                 case '"':
-                    s.push_back('"');
+                    scratch.push_back('"');
                     break;
                 case '\\':
-                    s.push_back('\\');
+                    scratch.push_back('\\');
                     break;
                 default:
                     throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            s.push_back(ch);
         }
-        ++it;
+        return scratch;
     }
 
-    return Node(std::move(s));
-}
+    void ReadLiteral(const char* begin, std::string_view literal) const {
+        const char* end = GetEnd();
+        const char* pos = begin;
+        while (pos != end && std::isalpha(static_cast<unsigned char>(*pos))) {
+            ++pos;
+        }
+        if (std::string_view(begin, pos - begin) != literal || !IsScalarEnd(pos)) {
+            throw ParsingError("Failed to parse '"s + std::string(begin, pos) + "' as "s
+                               + (literal == "null"sv ? "null"s : "bool"s));
+        }
+    }
 
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
+    // Проверяет грамматику числа JSON, затем преобразует его через std::from_chars и передаёт
+    // в on_number как int или double. Целое, не помещающееся в int, читается как double
+    template <typename NumberHandler>
+    auto ReadNumber(const char* begin, NumberHandler&& on_number) const {
+        const char* end = GetEnd();
+        const char* pos = begin;
+        const auto read_digits = [end, &pos] {
+            if (pos == end || !IsDigit(*pos)) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (pos != end && IsDigit(*pos)) {
+                ++pos;
+            }
+        };
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
+        if (pos != end && *pos == '-') {
+            ++pos;
+        }
+        // После 0 в JSON не могут идти другие цифры
+        if (pos != end && *pos == '0') {
+            ++pos;
+        } else {
+            read_digits();
         }
-    };
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
+        bool is_int = true;
+        if (pos != end && *pos == '.') {
+            ++pos;
+            read_digits();
+            is_int = false;
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        if (pos != end && (*pos == 'e' || *pos == 'E')) {
+            ++pos;
+            if (pos != end && (*pos == '+' || *pos == '-')) {
+                ++pos;
+            }
+            read_digits();
+            is_int = false;
+        }
+        if (!IsScalarEnd(pos)) {
+            throw ParsingError("Failed to convert "s + std::string(begin, pos + 1) + " to number"s);
         }
-    };
 
-    if (input.peek() == '-') {
-        read_char();
+        if (is_int) {
+            int value = 0;
+            if (const auto [ptr, ec] = std::from_chars(begin, pos, value); ec == std::errc{}) {
+                return on_number(value);
+            }
+        }
+        double value = 0.;
+        if (const auto [ptr, ec] = std::from_chars(begin, pos, value); ec != std::errc{}) {
+            throw ParsingError("Failed to convert "s + std::string(begin, pos) + " to number"s);
+        }
+        return on_number(value);
     }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    } else {
-        read_digits();
+
+    static void ExpectSeparator(char c, char closing) {
+        if (c != ',' && c != closing) {
+            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+        }
     }
 
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
+    static void ExpectKey(char c) {
+        if (c != '"') {
+            throw ParsingError(R"('"' is expected but ')"s + c + "' has been found"s);
+        }
     }
 
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    static void ExpectColon(char c) {
+        if (c != ':') {
+            throw ParsingError(": is expected but '"s + c + "' has been found"s);
         }
-        read_digits();
-        is_int = false;
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-            }
+private:
+    static bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // Число или литерал должны заканчиваться пробелом, структурным символом или концом ввода
+    bool IsScalarEnd(const char* pos) const {
+        if (pos == GetEnd()) {
+            return true;
+        }
+        switch (*pos) {
+            case ' ': case '\t': case '\n': case '\r':
+            case ',': case ']': case '}': case ':':
+                return true;
+            default:
+                return false;
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
     }
-}
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
+    const char* GetPointer(size_t position) const {
+        return window_.data() + (position - window_begin_);
+    }
 
-    for (char c; input >> c && c != '}';) {
-        if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
-                }
-                dict.emplace(std::move(key), LoadNode(input));
-            } else {
-                throw ParsingError(": is expected but '"s + c + "' has been found"s);
+    const char* GetEnd() const {
+        return window_.data() + window_.size();
+    }
+
+    bool HasToken() {
+        while (token_ == index_.size()) {
+            index_.clear();
+            token_ = 0;
+            if (scan_finished_) {
+                return false;
             }
-        } else if (c != ',') {
-            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            if (input_ != nullptr && !input_end_) {
+                ReadChunk();
+            }
+            const size_t scan_begin = scanned_ - window_begin_;
+            const size_t scan_size = std::min(window_.size() - scan_begin, CHUNK_SIZE);
+            scan_finished_ = input_end_ && scan_begin + scan_size == window_.size();
+            scanned_ += scanner_.Scan(window_.data() + scan_begin, scan_size, scanned_, scan_finished_, index_);
         }
+        return true;
     }
-    if (!input) {
-        throw ParsingError("Dictionary parsing error"s);
+
+    // Сдвигает окно: выбрасывает байты до последнего выданного символа индекса
+    // и дочитывает порцию из потока
+    void ReadChunk() {
+        buffer_.erase(0, last_position_ - window_begin_);
+        window_begin_ = last_position_;
+        const size_t size = buffer_.size();
+        buffer_.resize(size + CHUNK_SIZE);
+        input_->read(buffer_.data() + size, CHUNK_SIZE);
+        const size_t read_size = static_cast<size_t>(input_->gcount());
+        buffer_.resize(size + read_size);
+        input_end_ = read_size < CHUNK_SIZE;
+        window_ = buffer_;
     }
-    return Node(std::move(dict));
-}
 
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
-    if (s == "true"sv) {
-        return Node{true};
-    } else if (s == "false"sv) {
-        return Node{false};
-    } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+    std::istream* input_ = nullptr;
+    std::string buffer_;
+    // Часть ввода, доступная разбору: начинается с позиции window_begin_ от начала ввода
+    std::string_view window_;
+    size_t window_begin_ = 0;
+    bool input_end_ = false;
+    // Позиции от начала ввода
+    size_t scanned_ = 0;
+    size_t last_position_ = 0;
+    bool scan_finished_ = false;
+    StructuralScanner scanner_;
+    std::vector<size_t> index_;
+    size_t token_ = 0;
+};
+
+// Сортировка вставками для типичных словарей из нескольких ключей не выделяет память
+constexpr std::ptrdiff_t INSERTION_SORT_SIZE = 16;
+
+template <typename Iterator>
+void SortByKey(Iterator begin, Iterator end) {
+    const auto by_key = [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    };
+    if (end - begin > INSERTION_SORT_SIZE) {
+        std::stable_sort(begin, end, by_key);
+        return;
+    }
+    for (auto it = begin; it != end; ++it) {
+        for (auto pos = it; pos != begin && by_key(*pos, *(pos - 1)); --pos) {
+            std::iter_swap(pos, pos - 1);
+        }
     }
 }
 
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
-        return Node{nullptr};
-    } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+// Строки и контейнеры документа выделяются из resource. Элементы незаконченных массивов и словарей
+// копятся в общих стеках и переносятся в вектор точного размера, когда контейнер закрыт:
+// в арене не остаётся брошенных при росте векторов блоков
+class Parser : private TokenReader {
+public:
+    Parser(std::string_view input, std::pmr::memory_resource* resource)
+        : TokenReader(input)
+        , resource_(resource) {
     }
-}
 
-Node LoadNode(std::istream& input) {
-    char c;
-    if (!(input >> c)) {
-        throw ParsingError("Unexpected EOF"s);
+    Parser(std::istream& input, std::pmr::memory_resource* resource)
+        : TokenReader(input)
+        , resource_(resource) {
     }
-    switch (c) {
-        case '[':
-            return LoadArray(input);
-        case '{':
-            return LoadDict(input);
-        case '"':
-            return LoadString(input);
-        case 't':
-            [[fallthrough]];
-        case 'f':
-            input.putback(c);
-            return LoadBool(input);
-        case 'n':
-            input.putback(c);
-            return LoadNull(input);
-        default:
-            input.putback(c);
-            return LoadNumber(input);
+
+    Node ParseDocument() {
+        Node root = ParseNode();
+        ExpectEnd();
+        return root;
     }
-}
 
-struct PrintContext {
-    std::ostream& out;
-    int indent_step = 4;
-    int indent = 0;
+private:
+    Node ParseNode() {
+        const char* pos = NextPosition("Unexpected EOF"sv);
+        switch (*pos) {
+            case '[':
+                return ParseArray();
+            case '{':
+                return ParseDict();
+            case '"':
+                return Node(String(ReadString(scratch_), resource_));
+            case 't':
+                ReadLiteral(pos, "true"sv);
+                return Node{true};
+            case 'f':
+                ReadLiteral(pos, "false"sv);
+                return Node{false};
+            case 'n':
+                ReadLiteral(pos, "null"sv);
+                return Node{nullptr};
+            default:
+                return ReadNumber(pos, [](auto value) {
+                    return Node(value);
+                });
+        }
+    }
 
-    void PrintIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
+    Node ParseArray() {
+        if (PeekToken() == ']') {
+            SkipToken();
+            return Node(Array(resource_));
         }
+        const size_t first = array_items_.size();
+        for (char c = ','; c != ']'; ExpectSeparator(c, ']')) {
+            // Вложенные массивы возвращают стек к прежнему размеру до вставки этого элемента
+            array_items_.push_back(ParseNode());
+            c = NextToken("Array parsing error"sv);
+        }
+        const auto begin = array_items_.begin() + first;
+        Array result(std::make_move_iterator(begin), std::make_move_iterator(array_items_.end()), resource_);
+        array_items_.erase(begin, array_items_.end());
+        return Node(std::move(result));
     }
 
-    PrintContext Indented() const {
-        return {out, indent_step, indent_step + indent};
+    Node ParseDict() {
+        if (PeekToken() == '}') {
+            SkipToken();
+            return Node(Dict(Dict::Items(resource_)));
+        }
+        const size_t first = dict_items_.size();
+        for (char c = ','; c != '}'; ExpectSeparator(c, '}')) {
+            ExpectKey(NextToken("Dictionary parsing error"sv));
+            String key(ReadString(scratch_), resource_);
+            ExpectColon(NextToken("Dictionary parsing error"sv));
+            // Вложенные словари возвращают стек к прежнему размеру до вставки этого элемента
+            dict_items_.emplace_back(std::move(key), ParseNode());
+            c = NextToken("Dictionary parsing error"sv);
+        }
+        const auto begin = dict_items_.begin() + first;
+        Dict::Items items(std::make_move_iterator(begin), std::make_move_iterator(dict_items_.end()), resource_);
+        dict_items_.erase(begin, dict_items_.end());
+        try {
+            return Node(Dict(std::move(items)));
+        } catch (const invalid_argument& error) {
+            throw ParsingError(error.what());
+        }
     }
+
+    std::pmr::memory_resource* resource_;
+    std::vector<Node> array_items_;
+    std::vector<Dict::value_type> dict_items_;
+    std::string scratch_;
 };
 
+class SaxParser : private TokenReader {
+public:
+    SaxParser(std::string_view input, SaxHandler& handler)
+        : TokenReader(input)
+        , handler_(handler) {
+    }
 
-void PrintNode(const Node& value, const PrintContext& ctx);
+    SaxParser(std::istream& input, SaxHandler& handler)
+        : TokenReader(input)
+        , handler_(handler) {
+    }
 
-template <typename Value>
-void PrintValue(const Value& value, const PrintContext& ctx) {
-    ctx.out << value;
-}
+    void ParseDocument() {
+        ParseNode();
+        ExpectEnd();
+    }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
-        switch (c) {
-            case '\r':
-                out << "\\r"sv;
-                break;
-            case '\n':
-                out << "\\n"sv;
+private:
+    void ParseNode() {
+        const char* pos = NextPosition("Unexpected EOF"sv);
+        switch (*pos) {
+            case '[':
+                ParseArray();
                 break;
-            case '\t':
-                out << "\\t"sv;
+            case '{':
+                ParseDict();
                 break;
             case '"':
-                // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
-            case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
+                handler_.Value(ReadString(scratch_));
+                break;
+            case 't':
+                ReadLiteral(pos, "true"sv);
+                handler_.Value(true);
+                break;
+            case 'f':
+                ReadLiteral(pos, "false"sv);
+                handler_.Value(false);
+                break;
+            case 'n':
+                ReadLiteral(pos, "null"sv);
+                handler_.Value(nullptr);
                 break;
+            default:
+                ReadNumber(pos, [this](auto value) {
+                    handler_.Value(value);
+                });
         }
     }
-    out.put('"');
-}
 
-template <>
-void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
-    PrintString(value, ctx.out);
+    void ParseArray() {
+        handler_.StartArray();
+        if (PeekToken() == ']') {
+            SkipToken();
+        } else {
+            for (char c = ','; c != ']'; ExpectSeparator(c, ']')) {
+                ParseNode();
+                c = NextToken("Array parsing error"sv);
+            }
+        }
+        handler_.EndArray();
+    }
+
+    void ParseDict() {
+        handler_.StartDict();
+        if (PeekToken() == '}') {
+            SkipToken();
+        } else {
+            for (char c = ','; c != '}'; ExpectSeparator(c, '}')) {
+                ExpectKey(NextToken("Dictionary parsing error"sv));
+                handler_.Key(ReadString(scratch_));
+                ExpectColon(NextToken("Dictionary parsing error"sv));
+                ParseNode();
+                c = NextToken("Dictionary parsing error"sv);
+            }
+        }
+        handler_.EndDict();
+    }
+
+    SaxHandler& handler_;
+    std::string scratch_;
+};
+
+}  // namespace
+
+namespace detail {
+
+bool SetScanKernel(ScanKernel kernel) {
+    if (kernel == ScanKernel::SCALAR) {
+        GetClassifyBlockKernel() = ClassifyBlockScalar;
+        return true;
+    }
+#ifdef JSON_HAS_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        GetClassifyBlockKernel() = ClassifyBlockAvx2;
+        return true;
+    }
+#endif
+    return false;
 }
 
-template <>
-void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-    ctx.out << "null"sv;
+}  // namespace detail
+
+Dict::Dict(std::initializer_list<value_type> items)
+    : Dict(Items(items)) {
 }
 
-template <>
-void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-    ctx.out << (value ? "true"sv : "false"sv);
+// Ключи, уже идущие строго по возрастанию, проверяются за один проход. Иначе элементы
+// сортируются, и повторы ключей оказываются рядом
+Dict::Dict(Items items)
+    : items_(std::move(items)) {
+    const auto not_increasing = std::adjacent_find(items_.begin(), items_.end(),
+                                                   [](const value_type& lhs, const value_type& rhs) {
+                                                       return !(lhs.first < rhs.first);
+                                                   });
+    if (not_increasing == items_.end()) {
+        return;
+    }
+    SortByKey(items_.begin(), items_.end());
+    const auto duplicate = std::adjacent_find(items_.begin(), items_.end(),
+                                              [](const value_type& lhs, const value_type& rhs) {
+                                                  return lhs.first == rhs.first;
+                                              });
+    if (duplicate != items_.end()) {
+        throw invalid_argument("Duplicate key '"s + std::string(duplicate->first) + "' have been found"s);
+    }
 }
 
-template <>
-void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "[\n"sv;
-    bool first = true;
-    auto inner_ctx = ctx.Indented();
-    for (const Node& node : nodes) {
-        if (first) {
-            first = false;
-        } else {
-            out << ",\n"sv;
-        }
-        inner_ctx.PrintIndent();
-        PrintNode(node, inner_ctx);
+const Node& Dict::at(std::string_view key) const {
+    const auto it = find(key);
+    if (it == items_.end()) {
+        throw out_of_range("Key '"s + std::string(key) + "' is not found"s);
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put(']');
+    return it->second;
 }
 
-template <>
-void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "{\n"sv;
-    bool first = true;
-    auto inner_ctx = ctx.Indented();
-    for (const auto& [key, node] : nodes) {
-        if (first) {
-            first = false;
-        } else {
-            out << ",\n"sv;
-        }
-        inner_ctx.PrintIndent();
-        PrintString(key, ctx.out);
-        out << ": "sv;
-        PrintNode(node, inner_ctx);
+Node& Dict::operator[](std::string_view key) {
+    const auto it = items_.begin() + (LowerBound(key) - items_.cbegin());
+    if (it != items_.end() && it->first == key) {
+        return it->second;
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put('}');
+    return items_.emplace(it, key, Node{})->second;
 }
 
-void PrintNode(const Node& node, const PrintContext& ctx) {
-    std::visit(
-        [&ctx](const auto& value) {
-            PrintValue(value, ctx);
-        },
-        node.GetValue());
+Dict::const_iterator Dict::find(std::string_view key) const {
+    const auto it = LowerBound(key);
+    return it != items_.end() && it->first == key ? it : items_.end();
 }
 
-}  // namespace
+size_t Dict::count(std::string_view key) const {
+    return find(key) == items_.end() ? 0 : 1;
+}
+
+Dict::const_iterator Dict::begin() const {
+    return items_.begin();
+}
+
+Dict::const_iterator Dict::end() const {
+    return items_.end();
+}
+
+size_t Dict::size() const {
+    return items_.size();
+}
+
+bool Dict::empty() const {
+    return items_.empty();
+}
+
+bool Dict::operator==(const Dict& other) const {
+    return items_ == other.items_;
+}
+
+bool Dict::operator!=(const Dict& other) const {
+    return !(*this == other);
+}
+
+Dict::const_iterator Dict::LowerBound(std::string_view key) const {
+    return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+        return item.first < key;
+    });
+}
+
+Node::Node(const std::string& value)
+    : VariantType(String(std::string_view(value))) {
+}
 
 bool Node::IsInt() const {
     return holds_alternative<int>(*this);
@@ -349,7 +783,7 @@ bool Node::IsBool() const {
 }
 
 bool Node::IsString() const {
-    return holds_alternative<string>(*this);
+    return holds_alternative<String>(*this);
 }
 
 bool Node::IsNull() const {
@@ -364,45 +798,45 @@ bool Node::IsMap() const {
     return holds_alternative<Dict>(*this);
 }
 
+// Каждый метод проверяет тип одним get_if и сразу возвращает значение
 int Node::AsInt() const {
-    if (IsInt()) {
-            return get<int>(*this);
+    if (const auto* value = get_if<int>(&AsVariant())) {
+        return *value;
     }
     throw logic_error("Not an int");
 }
 
 double Node::AsDouble() const {
-    if (IsInt()) {
-        return static_cast<double>(get<int>(*this));
+    if (const auto* value = get_if<double>(&AsVariant())) {
+        return *value;
     }
-    if (IsDouble()) {
-        return get<double>(*this);
+    if (const auto* value = get_if<int>(&AsVariant())) {
+        return static_cast<double>(*value);
     }
-
     throw logic_error("Not a double");
 }
-const string& Node::AsString() const {
-    if (IsString()) {
-        return get<string>(*this);
+const String& Node::AsString() const {
+    if (const auto* value = get_if<String>(&AsVariant())) {
+        return *value;
     }
     throw logic_error("Not a string");
 }
 const Array& Node::AsArray() const {
-    if (IsArray()) { 
-        return get<Array>(*this);
+    if (const auto* value = get_if<Array>(&AsVariant())) {
+        return *value;
     }
     throw logic_error("Not an array");
 }
 bool Node::AsBool() const {
-    if(IsBool()) {
-        return get<bool>(*this);
+    if (const auto* value = get_if<bool>(&AsVariant())) {
+        return *value;
     }
     throw logic_error("Not a bool");
 }
 
 const Dict& Node::AsMap() const {
-    if(IsMap()) {
-        return get<Dict>(*this);
+    if (const auto* value = get_if<Dict>(&AsVariant())) {
+        return *value;
     }
     throw logic_error("Not a Map");
 }
@@ -423,27 +857,272 @@ const Node::Value& Node::GetValue() const {
 }
 
 bool Document::operator==(const Document& other) const {
-    return root_ == other.root_;
+    return GetRoot() == other.GetRoot();
 }
 bool Document::operator!=(const Document& other) const {
     return !(*this == other);
 }
 
 
+void Document::RootDeleter::operator()(Node* root) const {
+    if (!in_arena) {
+        delete root;
+    }
+}
+
 Document::Document(Node root)
-    : root_(move(root)) {
+    : root_(new Node(move(root)), RootDeleter{.in_arena = false}) {
+}
+
+Document::Document(const Document& other)
+    : Document(other.GetRoot()) {
+}
+
+Document& Document::operator=(const Document& other) {
+    return *this = Document(other);
+}
+
+Document::Document(std::unique_ptr<std::pmr::monotonic_buffer_resource> arena, Node* root)
+    : arena_(move(arena))
+    , root_(root, RootDeleter{.in_arena = true}) {
 }
 
 const Node& Document::GetRoot() const {
-    return root_;
+    return *root_;
+}
+
+namespace {
+
+// Первый блок арены; следующие блоки растут в геометрической прогрессии
+constexpr size_t ARENA_INITIAL_SIZE = 64 * 1024;
+
+}  // namespace
+
+Document Load(std::string_view input, Allocation allocation) {
+    if (allocation == Allocation::HEAP) {
+        return Document{Parser(input, pmr::get_default_resource()).ParseDocument()};
+    }
+    auto arena = make_unique<pmr::monotonic_buffer_resource>(ARENA_INITIAL_SIZE);
+    Node* root = pmr::polymorphic_allocator<>(arena.get()).new_object<Node>(Parser(input, arena.get()).ParseDocument());
+    return Document(move(arena), root);
+}
+
+// Поток читается порциями по мере разбора
+Document Load(istream& input, Allocation allocation) {
+    if (allocation == Allocation::HEAP) {
+        return Document{Parser(input, pmr::get_default_resource()).ParseDocument()};
+    }
+    auto arena = make_unique<pmr::monotonic_buffer_resource>(ARENA_INITIAL_SIZE);
+    Node* root = pmr::polymorphic_allocator<>(arena.get()).new_object<Node>(Parser(input, arena.get()).ParseDocument());
+    return Document(move(arena), root);
+}
+
+void Parse(std::string_view input, SaxHandler& handler) {
+    SaxParser(input, handler).ParseDocument();
+}
+
+void Parse(std::istream& input, SaxHandler& handler) {
+    SaxParser(input, handler).ParseDocument();
 }
 
-Document Load(istream& input) {
-    return Document{LoadNode(input)};
+Serializer::Serializer(std::string& buffer, std::ostream* output, PrintFormat format)
+    : buffer_(buffer)
+    , output_(output)
+    , pretty_(format == PrintFormat::PRETTY) {
 }
 
-void Print(const Document& doc, std::ostream& output) {
-    PrintNode(doc.GetRoot(), PrintContext{output});
+void Serializer::WriteNode(const Node& node, size_t indent) {
+    std::visit(
+        [this, indent](const auto& value) {
+            using Value = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<Value, std::nullptr_t>) {
+                WriteNull();
+            } else if constexpr (std::is_same_v<Value, Array>) {
+                WriteArray(value, indent);
+            } else if constexpr (std::is_same_v<Value, Dict>) {
+                WriteDict(value, indent);
+            } else if constexpr (std::is_same_v<Value, String>) {
+                WriteString(value);
+            } else {
+                WriteScalar(value);
+            }
+        },
+        node.GetValue());
+}
+
+void Serializer::WriteNull() {
+    Append("null"sv);
+}
+
+void Serializer::WriteScalar(bool value) {
+    Append(value ? "true"sv : "false"sv);
+}
+
+void Serializer::WriteScalar(int value) {
+    std::array<char, 16> chars;
+    const auto result = std::to_chars(chars.data(), chars.data() + chars.size(), value);
+    Append(std::string_view(chars.data(), result.ptr - chars.data()));
+}
+
+void Serializer::WriteScalar(double value) {
+    std::array<char, 32> chars;
+    const auto result = std::to_chars(chars.data(), chars.data() + chars.size(), value,
+                                      std::chars_format::general, 6);
+    Append(std::string_view(chars.data(), result.ptr - chars.data()));
+}
+
+// Символы без экранирования копируются в буфер целыми отрезками
+void Serializer::WriteString(std::string_view value) {
+    buffer_.push_back('"');
+    size_t plain_begin = 0;
+    for (size_t pos = 0; pos < value.size(); ++pos) {
+        std::string_view escaped;
+        switch (value[pos]) {
+            case '\r':
+                escaped = "\\r"sv;
+                break;
+            case '\n':
+                escaped = "\\n"sv;
+                break;
+            case '\t':
+                escaped = "\\t"sv;
+                break;
+            case '"':
+                escaped = "\\\""sv;
+                break;
+            case '\\':
+                escaped = "\\\\"sv;
+                break;
+            default:
+                continue;
+        }
+        buffer_.append(value.substr(plain_begin, pos - plain_begin));
+        buffer_.append(escaped);
+        plain_begin = pos + 1;
+    }
+    buffer_.append(value.substr(plain_begin));
+    buffer_.push_back('"');
+    FlushIfFull();
+}
+
+void Serializer::StartContainer(char bracket) {
+    buffer_.push_back(bracket);
+    if (pretty_) {
+        buffer_.push_back('\n');
+    }
+}
+
+void Serializer::StartElement(bool first, size_t indent) {
+    if (!first) {
+        buffer_.push_back(',');
+        if (pretty_) {
+            buffer_.push_back('\n');
+        }
+    }
+    if (pretty_) {
+        buffer_.append(indent, ' ');
+    }
+}
+
+void Serializer::WriteColon() {
+    buffer_.append(pretty_ ? ": "sv : ":"sv);
+}
+
+void Serializer::EndContainer(char bracket, size_t indent) {
+    if (pretty_) {
+        buffer_.push_back('\n');
+        buffer_.append(indent, ' ');
+    }
+    buffer_.push_back(bracket);
+    FlushIfFull();
+}
+
+void Serializer::Append(std::string_view text) {
+    buffer_.append(text);
+    FlushIfFull();
+}
+
+void Serializer::Flush() {
+    if (output_ != nullptr && !buffer_.empty()) {
+        output_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+}
+
+void Serializer::FlushIfFull() {
+    if (buffer_.size() >= FLUSH_SIZE) {
+        Flush();
+    }
+}
+
+void Serializer::WriteArray(const Array& nodes, size_t indent) {
+    StartContainer('[');
+    bool first = true;
+    for (const Node& node : nodes) {
+        StartElement(first, indent + INDENT_STEP);
+        first = false;
+        WriteNode(node, indent + INDENT_STEP);
+    }
+    EndContainer(']', indent);
+}
+
+void Serializer::WriteDict(const Dict& nodes, size_t indent) {
+    StartContainer('{');
+    bool first = true;
+    for (const auto& [key, node] : nodes) {
+        StartElement(first, indent + INDENT_STEP);
+        first = false;
+        WriteString(key);
+        WriteColon();
+        WriteNode(node, indent + INDENT_STEP);
+    }
+    EndContainer('}', indent);
+}
+
+void Print(const Document& doc, std::ostream& output, PrintFormat format) {
+    std::string buffer;
+    Serializer serializer(buffer, &output, format);
+    serializer.WriteNode(doc.GetRoot(), 0);
+    serializer.Flush();
+}
+
+ArrayPrinter::ArrayPrinter(std::ostream& output, PrintFormat format)
+    : output_(output)
+    , format_(format) {
+    Serializer(buffer_, &output_, format_).StartContainer('[');
+}
+
+void ArrayPrinter::Print(const Node& node) {
+    StartElement();
+    Serializer(buffer_, &output_, format_).WriteNode(node, Serializer::INDENT_STEP);
+}
+
+void ArrayPrinter::PrintSerialized(std::string_view element) {
+    StartElement();
+    Serializer(buffer_, &output_, format_).Append(element);
+}
+
+void ArrayPrinter::Flush() {
+    Serializer(buffer_, &output_, format_).Flush();
+    output_.flush();
+}
+
+void ArrayPrinter::StartElement() {
+    if (finished_) {
+        throw logic_error("Array is finished");
+    }
+    Serializer(buffer_, &output_, format_).StartElement(empty_, Serializer::INDENT_STEP);
+    empty_ = false;
+}
+
+void ArrayPrinter::Finish() {
+    if (finished_) {
+        throw logic_error("Array is finished");
+    }
+    finished_ = true;
+    Serializer serializer(buffer_, &output_, format_);
+    serializer.EndContainer(']', 0);
+    serializer.Flush();
 }
 
 }  // namespace json
\ No newline at end of file
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <initializer_list>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -10,15 +15,52 @@ namespace json {
 
     class Node;
 
-    using Dict = std::map<std::string, Node>;
-    using Array = std::vector<Node>;
+    // Строки и контейнеры документа берут память из memory_resource: при разборе с
+    // Allocation::ARENA — из арены документа, иначе из ресурса по умолчанию, то есть из кучи
+    using String = std::pmr::string;
+    using Array = std::pmr::vector<Node>;
+
+    // Словарь — вектор пар, отсортированный по ключу: элементы лежат подряд, поиск — двоичный,
+    // обход идёт по алфавиту ключей, как у std::map. Короткие ключи хранятся внутри строки
+    // без отдельного выделения памяти. Вставка нового ключа сдвигает хвост вектора, поэтому
+    // большие словари лучше собирать целиком и передавать в конструктор
+    class Dict {
+    public:
+        using value_type = std::pair<String, Node>;
+        using Items = std::pmr::vector<value_type>;
+        using const_iterator = Items::const_iterator;
+
+        Dict() = default;
+        Dict(std::initializer_list<value_type> items);
+        // Элементы сортируются по ключу; повтор ключа — std::invalid_argument.
+        // Строки ключей должны брать память из того же ресурса, что и items
+        explicit Dict(Items items);
+
+        const Node& at(std::string_view key) const;
+        Node& operator[](std::string_view key);
+        const_iterator find(std::string_view key) const;
+        size_t count(std::string_view key) const;
+
+        const_iterator begin() const;
+        const_iterator end() const;
+        size_t size() const;
+        bool empty() const;
+
+        bool operator==(const Dict& other) const;
+        bool operator!=(const Dict& other) const;
+
+    private:
+        const_iterator LowerBound(std::string_view key) const;
+
+        Items items_;
+    };
 
     class ParsingError : public std::runtime_error {
     public:
         using runtime_error::runtime_error;
     };
 
-    using VariantType = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>;
+    using VariantType = std::variant<std::nullptr_t, Array, Dict, bool, int, double, String>;
 
     class Node final
     : private VariantType
@@ -27,12 +69,15 @@ namespace json {
         using variant::variant;
         using Value = variant;
 
+        // Строка из кучи копируется в String
+        Node(const std::string& value);
+
         const Array& AsArray() const;
         const Dict& AsMap() const;
         int AsInt() const;
         bool AsBool() const;
         double AsDouble() const;
-        const std::string& AsString() const;
+        const String& AsString() const;
 
         bool IsInt() const;
         bool IsDouble() const;
@@ -50,9 +95,26 @@ namespace json {
         const VariantType& AsVariant() const;
     };
 
+    // Где разбор документа выделяет память под узлы
+    enum class Allocation {
+        HEAP,   // каждая строка и каждый контейнер выделяются и освобождаются по отдельности
+        ARENA   // всё выделяется подряд из арены документа, уничтожение документа — освобождение арены
+    };
+
+    class Document;
+
+    Document Load(std::istream& input, Allocation allocation = Allocation::HEAP);
+    // Разбор документа из буфера в памяти
+    Document Load(std::string_view input, Allocation allocation = Allocation::HEAP);
+
     class Document {
     public:
         explicit Document(Node root);
+        // Копия всегда хранится в куче
+        Document(const Document& other);
+        Document(Document&& other) = default;
+        Document& operator=(const Document& other);
+        Document& operator=(Document&& other) = default;
 
         const Node& GetRoot() const;
 
@@ -60,11 +122,127 @@ namespace json {
         bool operator!=(const Document& other) const;
 
     private:
-        Node root_;
+        friend Document Load(std::istream& input, Allocation allocation);
+        friend Document Load(std::string_view input, Allocation allocation);
+
+        // Корень в арене не уничтожается: память всех узлов освобождается вместе с ареной
+        struct RootDeleter {
+            bool in_arena;
+            void operator()(Node* root) const;
+        };
+
+        Document(std::unique_ptr<std::pmr::monotonic_buffer_resource> arena, Node* root);
+
+        // Арена объявлена первой и освобождается после корня
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+        std::unique_ptr<Node, RootDeleter> root_;
     };
 
-    Document Load(std::istream& input);
+    // Обработчик событий потокового разбора: документ не строится, каждое значение передаётся
+    // в обработчик сразу после чтения. Строки действительны только на время вызова,
+    // повторяющиеся ключи словаря не проверяются
+    class SaxHandler {
+    public:
+        virtual ~SaxHandler() = default;
+
+        virtual void StartDict() = 0;
+        virtual void EndDict() = 0;
+        virtual void StartArray() = 0;
+        virtual void EndArray() = 0;
+        virtual void Key(std::string_view key) = 0;
+        virtual void Value(std::nullptr_t value) = 0;
+        virtual void Value(bool value) = 0;
+        virtual void Value(int value) = 0;
+        virtual void Value(double value) = 0;
+        virtual void Value(std::string_view value) = 0;
+    };
 
-    void Print(const Document& doc, std::ostream& output);
+    void Parse(std::istream& input, SaxHandler& handler);
+    void Parse(std::string_view input, SaxHandler& handler);
+
+    namespace detail {
+        // Ядро первого этапа разбора, размечающее блоки ввода
+        enum class ScanKernel {
+            SCALAR,
+            AVX2    // только на x86 и только если процессор поддерживает AVX2
+        };
+
+        // По умолчанию выбирается AVX2, если оно доступно. Переключение нужно, чтобы проверить,
+        // что оба ядра строят одинаковые документы; вызывать только когда разбор не идёт.
+        // false — ядро недоступно, выбор не изменился
+        bool SetScanKernel(ScanKernel kernel);
+    }  // namespace detail
+
+    enum class PrintFormat {
+        PRETTY,     // каждый элемент с новой строки, отступ — 4 пробела на уровень
+        COMPACT     // без пробелов и переводов строк
+    };
+
+    // Вывод JSON в строковый буфер — общая часть Print, ArrayPrinter и Writer. Если задан поток,
+    // накопленный текст уходит в него крупными порциями, иначе буфер просто растёт. Числа выводятся
+    // через std::to_chars: double — в общем формате с точностью 6, как у потока по умолчанию
+    class Serializer {
+    public:
+        static constexpr size_t FLUSH_SIZE = 64 * 1024;
+        static constexpr size_t INDENT_STEP = 4;
+
+        Serializer(std::string& buffer, std::ostream* output, PrintFormat format);
+
+        // indent — отступ строки, на которой начинается значение
+        void WriteNode(const Node& node, size_t indent);
+        void WriteNull();
+        void WriteScalar(bool value);
+        void WriteScalar(int value);
+        void WriteScalar(double value);
+        void WriteString(std::string_view value);
+
+        // Элементы контейнера: перед каждым, кроме первого, идёт запятая, в формате PRETTY
+        // каждый элемент начинается с новой строки с отступом indent
+        void StartContainer(char bracket);
+        void StartElement(bool first, size_t indent);
+        // Разделитель ключа и значения словаря
+        void WriteColon();
+        void EndContainer(char bracket, size_t indent);
+
+        void Append(std::string_view text);
+        void Flush();
+
+    private:
+        void FlushIfFull();
+        void WriteArray(const Array& nodes, size_t indent);
+        void WriteDict(const Dict& nodes, size_t indent);
+
+        std::string& buffer_;
+        std::ostream* output_;
+        bool pretty_;
+    };
+
+    // Текст копится в буфере и записывается в поток крупными порциями
+    void Print(const Document& doc, std::ostream& output, PrintFormat format = PrintFormat::PRETTY);
+
+    // Вывод массива по одному элементу, без построения самого массива. Результат совпадает
+    // с выводом Print для массива из тех же элементов
+    class ArrayPrinter {
+    public:
+        explicit ArrayPrinter(std::ostream& output, PrintFormat format = PrintFormat::PRETTY);
+
+        void Print(const Node& node);
+        // Элемент, уже выведенный с отступом Serializer::INDENT_STEP, например через Writer:
+        // элементы можно готовить независимо друг от друга, в том числе в разных потоках
+        void PrintSerialized(std::string_view element);
+        // Записывает накопленный текст в поток и сбрасывает поток
+        void Flush();
+        // Закрывает массив и записывает остаток текста, после вызова выводить элементы нельзя
+        void Finish();
+
+    private:
+        void StartElement();
+
+        std::ostream& output_;
+        PrintFormat format_;
+        std::string buffer_;
+        bool empty_ = true;
+        bool finished_ = false;
+    };
 
 }  // namespace json
\ No newline at end of file
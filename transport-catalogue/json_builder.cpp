@@ -23,9 +23,9 @@ namespace json {
         return KeyItemContext(*this);
     }       
 
-    Builder& Builder::Value(Node::Value val) {
+    Builder& Builder::Value(Node value) {
         CheckNotBuilt();
-        AddNode(std::move(Typed(val)));
+        AddNode(std::move(value));
         return *this;
     }    
 
@@ -87,23 +87,6 @@ namespace json {
         }
     }
 
-    Node Builder::Typed(Node::Value val) const {
-        if (std::holds_alternative<int>(val)) {
-            return Node(std::get<int>(val)); 
-        } else if (std::holds_alternative<double>(val)) {
-            return Node(std::get<double>(val));
-        } else if (std::holds_alternative<std::string>(val)) {
-            return Node(std::get<std::string>(val)); 
-        } else if (std::holds_alternative<json::Array>(val)) {
-            return Node(std::get<json::Array>(val));  
-        } else if (std::holds_alternative<json::Dict>(val)) {
-            return Node(std::get<json::Dict>(val));
-        } else if (std::holds_alternative<bool>(val)) {
-            return Node(std::get<bool>(val)); 
-        }
-        return Node(nullptr);
-    }
-
     void Builder::AddComplexNode(ComplexType type) {
         if (nodes_stack_.empty() && root_.IsNull()) {
             if(ComplexType::IsArray) {
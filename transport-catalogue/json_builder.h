@@ -15,7 +15,7 @@ namespace json {
 
         Node Build();
         KeyItemContext Key(std::string key);
-        Builder& Value(Node::Value val);
+        Builder& Value(Node value);
         DictItemContext StartDict();
         ArrayItemContext StartArray();
         Builder& EndDict();
@@ -34,7 +34,6 @@ namespace json {
         };
 
         void CheckNotBuilt() const;
-        Node Typed(Node::Value val) const;
         void AddComplexNode(ComplexType type);
         void AddNode(Node&& node);
         bool EmptyJson() const;
@@ -48,7 +47,7 @@ namespace json {
                 KeyItemContext Key(std::string key) {
                     return builder_.Key(std::move(key));
                 }
-                BaseContext Value(Node::Value value) {
+                BaseContext Value(Node value) {
                     return builder_.Value(std::move(value));
                 }
                 DictItemContext StartDict() {
@@ -71,7 +70,7 @@ namespace json {
         public:
             DictItemContext(BaseContext base) : BaseContext(base) {}
             Node Build() = delete;
-            BaseContext Value(Node::Value value) = delete;
+            BaseContext Value(Node value) = delete;
             BaseContext EndArray() = delete;
             DictItemContext StartDict() = delete;
             ArrayItemContext StartArray() = delete;
@@ -84,13 +83,13 @@ namespace json {
             DictItemContext Key(std::string key) = delete;
             BaseContext EndDict() = delete;
             BaseContext EndArray() = delete;
-            DictItemContext Value(Node::Value value) { return BaseContext::Value(std::move(value)); }
+            DictItemContext Value(Node value) { return BaseContext::Value(std::move(value)); }
         };
         
         class ArrayItemContext : public BaseContext {
         public:
             ArrayItemContext(BaseContext base) : BaseContext(base) {}
-            ArrayItemContext Value(Node::Value value) { return BaseContext::Value(std::move(value)); }
+            ArrayItemContext Value(Node value) { return BaseContext::Value(std::move(value)); }
             Node Build() = delete;
             KeyItemContext Key(std::string key) = delete;
             BaseContext EndDict() = delete;
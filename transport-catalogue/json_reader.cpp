@@ -1,15 +1,302 @@
 #include "json_reader.h"
 
+#include "parallel.h"
+
 namespace json_reader {
-    JsonReader::JsonReader(std::istream& input) 
-        : doc_(json::Load(input))
-        , catalogue_(transport_catalogue::TransportCatalogue()) {
+    // Потоковая обработка: запросы base_requests и stat_requests по одному собираются в небольшой
+    // Node. Запрос к базе сразу добавляется в справочник, ответ на запрос статистики сразу выводится,
+    // остальные разделы корневого словаря попадают в документ как есть.
+    // Остановка может встретиться в маршруте или в road_distances раньше своего описания: тогда
+    // она добавляется без координат, которые задаются, когда описание дойдёт
+    class JsonReader::StreamLoader final : public json::SaxHandler {
+    public:
+        StreamLoader(JsonReader& reader, std::ostream& output)
+            : reader_(reader)
+            , catalogue_(reader.catalogue_)
+            , printer_(output, reader.settings_.output_format) {
+        }
+
+        // Возвращает документ из оставшихся разделов
+        json::Document Process(Input input) {
+            if (auto* stream = std::get_if<std::istream*>(&input)) {
+                json::Parse(**stream, *this);
+            }
+            else {
+                json::Parse(std::get<std::string_view>(input), *this);
+            }
+            // Запросы шли раньше нужных для ответа разделов и ждали в документе
+            if (!handler_) {
+                StartAnswering();
+                reader_.AnswerAllRequests(root_.at("stat_requests").AsArray(), *handler_, printer_);
+            }
+            printer_.Finish();
+            return json::Document(json::Node(std::move(root_)));
+        }
+
+        void StartDict() override {
+            if (depth_ == 0) {
+                ++depth_;
+                return;
+            }
+            StartValue();
+            builder_.StartDict();
+            ++depth_;
+        }
+
+        void EndDict() override {
+            if (--depth_ == 0) {
+                return;
+            }
+            builder_.EndDict();
+            EndValue();
+        }
+
+        void StartArray() override {
+            CheckRoot();
+            if (depth_ == 1 && section_ == "base_requests") {
+                section_state_ = SectionState::BASE_REQUESTS;
+                ++depth_;
+                return;
+            }
+            if (depth_ == 1 && section_ == "stat_requests" && CanAnswer()) {
+                StartAnswering();
+                section_state_ = SectionState::STAT_REQUESTS;
+                ++depth_;
+                return;
+            }
+            StartValue();
+            builder_.StartArray();
+            ++depth_;
+        }
+
+        void EndArray() override {
+            --depth_;
+            if (section_state_ != SectionState::OTHER && depth_ == 1) {
+                if (section_state_ == SectionState::BASE_REQUESTS) {
+                    base_requests_read_ = true;
+                }
+                else {
+                    AnswerPendingRequests();
+                }
+                section_state_ = SectionState::OTHER;
+                return;
+            }
+            builder_.EndArray();
+            EndValue();
+        }
+
+        void Key(std::string_view key) override {
+            if (depth_ == 1) {
+                section_ = key;
+            }
+            else {
+                builder_.Key(std::string(key));
+            }
+        }
+
+        void Value(std::nullptr_t value) override {
+            AddScalar(value);
+        }
+
+        void Value(bool value) override {
+            AddScalar(value);
+        }
+
+        void Value(int value) override {
+            AddScalar(value);
+        }
+
+        void Value(double value) override {
+            AddScalar(value);
+        }
+
+        void Value(std::string_view value) override {
+            AddScalar(json::String(value));
+        }
+
+    private:
+        // Раздел корня, массив которого обрабатывается по одному элементу
+        enum class SectionState {
+            OTHER,
+            BASE_REQUESTS,
+            STAT_REQUESTS
+        };
+
+        // Глубина, на которой заканчивается значение, собираемое целиком: раздел корня
+        // или один запрос внутри base_requests и stat_requests
+        size_t GetValueDepth() const {
+            return section_state_ == SectionState::OTHER ? 1 : 2;
+        }
+
+        bool CanAnswer() const {
+            return base_requests_read_ && root_.count("render_settings") > 0 && root_.count("routing_settings") > 0;
+        }
+
+        // Справочник заполнен: строятся визуализатор и маршрутизатор
+        void StartAnswering() {
+            for (domain::StopId stop = 0; stop < defined_stops_.size(); ++stop) {
+                if (!defined_stops_[stop]) {
+                    throw std::invalid_argument("Stop is not described: " + std::string(catalogue_.GetStop(stop).stop_name));
+                }
+            }
+            catalogue_.Finalize();
+            renderer_.emplace(reader_.GetRenderSettings(root_.at("render_settings").AsMap()));
+            router_.emplace(catalogue_, reader_.GetRoutingSettings(root_.at("routing_settings").AsMap()));
+            handler_.emplace(catalogue_, *renderer_, *router_);
+        }
+
+        // Запросы копятся до размера пачки, ответы выводятся сразу и не задерживаются в буфере потока
+        void AddRequest(json::Node request) {
+            pending_requests_.push_back(std::move(request));
+            if (pending_requests_.size() == reader_.GetRequestBatchSize()) {
+                AnswerPendingRequests();
+            }
+        }
+
+        void AnswerPendingRequests() {
+            std::vector<const json::Dict*> requests;
+            requests.reserve(pending_requests_.size());
+            for (const auto& request : pending_requests_) {
+                requests.push_back(&request.AsMap());
+            }
+            reader_.AnswerRequests(requests, *handler_, printer_);
+            pending_requests_.clear();
+            printer_.Flush();
+        }
+
+        void CheckRoot() const {
+            if (depth_ == 0) {
+                throw std::invalid_argument("Root of the document should be a dictionary");
+            }
+        }
+
+        void StartValue() {
+            if (depth_ == GetValueDepth()) {
+                builder_ = json::Builder{};
+            }
+        }
+
+        void EndValue() {
+            if (depth_ == GetValueDepth()) {
+                AddValue(builder_.Build());
+            }
+        }
+
+        template <typename Value>
+        void AddScalar(Value value) {
+            CheckRoot();
+            if (depth_ == GetValueDepth()) {
+                AddValue(json::Node(std::move(value)));
+            }
+            else {
+                builder_.Value(std::move(value));
+            }
+        }
+
+        void AddValue(json::Node value) {
+            if (section_state_ == SectionState::OTHER) {
+                root_[section_] = std::move(value);
+                return;
+            }
+            if (section_state_ == SectionState::STAT_REQUESTS) {
+                AddRequest(std::move(value));
+                return;
+            }
+            const auto& element = value.AsMap();
+            if (const auto& type = element.at("type").AsString(); type == "Stop") {
+                AddStop(element);
+            }
+            else if (type == "Bus") {
+                AddBus(element);
+            }
+        }
+
+        void AddStop(const json::Dict& element) {
+            const domain::StopId stop = GetStopId(element.at("name").AsString());
+            defined_stops_[stop] = true;
+            catalogue_.SetStopCoordinates(stop, geo::Coordinates{element.at("latitude").AsDouble(),
+                                                                 element.at("longitude").AsDouble()});
+            for (const auto& [neighbor_stop, distance] : element.at("road_distances").AsMap()) {
+                catalogue_.SetStopDistance(stop, GetStopId(neighbor_stop), distance.AsInt());
+            }
+        }
+
+        void AddBus(const json::Dict& element) {
+            const bool is_roundtrip = element.at("is_roundtrip").AsBool();
+            std::vector<domain::StopId> bus_stops;
+            for (const auto stop_name : reader_.GetRoute(element.at("stops").AsArray(), is_roundtrip)) {
+                bus_stops.push_back(GetStopId(stop_name));
+            }
+            catalogue_.AddBus(element.at("name").AsString(), is_roundtrip, bus_stops, reader_.GetDepartures(element));
+        }
+
+        domain::StopId GetStopId(std::string_view name) {
+            if (const auto stop = catalogue_.FindStopByName(name)) {
+                return stop->id;
+            }
+            defined_stops_.push_back(false);
+            return catalogue_.AddStop(name, geo::Coordinates{}).id;
+        }
+
+        JsonReader& reader_;
+        transport_catalogue::TransportCatalogue& catalogue_;
+        json::Dict root_;
+        json::Builder builder_;
+        size_t depth_ = 0;
+        std::string section_;
+        SectionState section_state_ = SectionState::OTHER;
+        bool base_requests_read_ = false;
+        // Индекс — StopId: встретилось ли уже описание остановки
+        std::vector<bool> defined_stops_;
+        std::optional<renderer::MapRenderer> renderer_;
+        std::optional<router::TransportRouter> router_;
+        std::optional<request_handler::RequestHandler> handler_;
+        std::vector<json::Node> pending_requests_;
+        json::ArrayPrinter printer_;
+    };
+
+    JsonReader::JsonReader(std::istream& input, Settings settings)
+        : JsonReader(Input(&input), settings) {
+    }
+
+    JsonReader::JsonReader(std::string_view input, Settings settings)
+        : JsonReader(Input(input), settings) {
+    }
+
+    // В потоковом режиме запросы к базе живут, только пока разбираются, поэтому имена копируются
+    JsonReader::JsonReader(Input input, Settings settings)
+        : settings_(settings)
+        , input_(input)
+        , doc_(settings.input_mode == InputMode::STREAM ? json::Document(json::Dict{}) : LoadDocument(input))
+        , catalogue_(settings.input_mode == InputMode::STREAM ? transport_catalogue::NameStorage::COPY
+                                                              : transport_catalogue::NameStorage::REFERENCE) {
+        settings_.request_threads = parallel::ResolveThreadCount(settings.request_threads);
+    }
+
+    json::Document JsonReader::LoadDocument(Input input) {
+        if (auto* stream = std::get_if<std::istream*>(&input)) {
+            return json::Load(**stream, json::Allocation::ARENA);
+        }
+        return json::Load(std::get<std::string_view>(input), json::Allocation::ARENA);
+    }
+
+    void JsonReader::ProcessStream(std::ostream& output) {
+        CheckMode(InputMode::STREAM);
+        doc_ = StreamLoader(*this, output).Process(input_);
+    }
+
+    void JsonReader::CheckMode(InputMode mode) const {
+        if (settings_.input_mode != mode) {
+            throw std::logic_error("Method is not available in this input mode");
+        }
     }
 
     void JsonReader::BuildBase() {
+        CheckMode(InputMode::DOCUMENT);
         const auto& db_req_array = doc_.GetRoot().AsMap().at("base_requests").AsArray();
         AddStops(db_req_array);
         AddBuses(db_req_array);
+        catalogue_.Finalize();
     }
 
     const transport_catalogue::TransportCatalogue& JsonReader::GetCatalogue() const {
@@ -31,34 +318,29 @@ namespace json_reader {
         result += "\"";
         return result;
     }
-    void JsonReader::HandleStopRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Builder& builder) const {
+    // Ключи словарей ответов выводятся по алфавиту, как у json::Dict
+    void JsonReader::HandleStopRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const {
         auto response = handler.GetBusesByStop(command_data.at("name").AsString());
         if (response) {
-            json::Array bus_arr;
-            bus_arr.reserve(response.value().size());
-            
-            std::transform(
-                response.value().begin(), response.value().end(),
-                std::back_inserter(bus_arr),
-                [](auto& bus) { return std::string(bus); } 
-            );
-
-            builder.StartDict()
-                        .Key("buses").Value(bus_arr)
+            auto buses = writer.StartDict().Key("buses").StartArray();
+            for (const domain::BusId bus : *response) {
+                buses.Value(handler.GetBusName(bus));
+            }
+            buses.EndArray()
                         .Key("request_id").Value(command_data.at("id").AsInt())
                       .EndDict();
         }
         else {
-            builder.StartDict()
+            writer.StartDict()
                         .Key("error_message").Value("not found")
                         .Key("request_id").Value(command_data.at("id").AsInt())
                       .EndDict();
         }
     }
-    void JsonReader::HandleBusRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Builder& builder) const {      
+    void JsonReader::HandleBusRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const {      
         auto response = handler.GetBusStat(command_data.at("name").AsString());
         if (response) {
-            builder.StartDict()
+            writer.StartDict()
                         .Key("curvature").Value(response.value().curvature)
                         .Key("request_id").Value(command_data.at("id").AsInt())
                         .Key("route_length").Value(response.value().distance)
@@ -67,91 +349,235 @@ namespace json_reader {
                       .EndDict();
         }
         else {
-            builder.StartDict()
+            writer.StartDict()
                         .Key("error_message").Value("not found")
                         .Key("request_id").Value(command_data.at("id").AsInt())
                       .EndDict();
         }
     }
-    void JsonReader::HandleRouteRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Builder& builder) const {
-        auto response = handler.BuildRoute(command_data.at("from").AsString(), command_data.at("to").AsString());
-        json::Array items;
+    void JsonReader::HandleRouteRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const {
+        if (const auto it = command_data.find("pareto"); it != command_data.end() && it->second.AsBool()) {
+            HandleParetoRouteRequest(command_data, handler, writer);
+            return;
+        }
+        const auto& from = command_data.at("from").AsString();
+        const auto& to = command_data.at("to").AsString();
+        const auto max_transfers = GetMaxTransfers(command_data);
+        std::optional<router::RoutingResult> response;
+        if (const auto it = command_data.find("departure_time"); it != command_data.end()) {
+            response = handler.BuildRouteDepartingAt(from, to, it->second.AsDouble());
+        }
+        else if (max_transfers) {
+            response = handler.BuildRoute(from, to, *max_transfers);
+        }
+        else {
+            response = handler.BuildRoute(from, to);
+        }
         if (!response) {
-            builder
+            writer
                 .StartDict()
-                    .Key("request_id").Value(command_data.at("id").AsInt())
                     .Key("error_message").Value("not found")
+                    .Key("request_id").Value(command_data.at("id").AsInt())
                 .EndDict();        
         }
         else {
-            for (const auto& element : response->records) {
-                if (element.is_bus) { // Это автобусный сегмент
-                    items.emplace_back(
-                        json::Builder{}
-                            .StartDict()
-                                .Key("type").Value("Bus")
-                                .Key("bus").Value(element.name)
-                                .Key("span_count").Value(element.span_count)
-                                .Key("time").Value(element.time)
-                            .EndDict()
-                        .Build()
-                    );
-                } else { // Это ожидание на остановке
-                    items.emplace_back(
-                        json::Builder{}
-                            .StartDict()
-                                .Key("type").Value("Wait")
-                                .Key("stop_name").Value(element.name)
-                                .Key("time").Value(element.time)
-                            .EndDict()
-                        .Build()
-                    );
-                }
-            }
-            builder
-            .StartDict()
+            writer.StartDict().Key("items");
+            WriteRouteItems(*response, writer);
+            writer
                 .Key("request_id").Value(command_data.at("id").AsInt())
                 .Key("total_time").Value(response->travel_time)
-                .Key("items").Value(items)
             .EndDict();   
         }
     }
-    void JsonReader::HandleMapRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Builder& builder) const {
+    // Ответ — все маршруты, которые нельзя улучшить сразу и по времени, и по числу пересадок
+    void JsonReader::HandleParetoRouteRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const {
+        const auto routes = handler.BuildParetoRoutes(command_data.at("from").AsString(),
+                                                      command_data.at("to").AsString(),
+                                                      GetMaxTransfers(command_data));
+        if (routes.empty()) {
+            writer
+                .StartDict()
+                    .Key("error_message").Value("not found")
+                    .Key("request_id").Value(command_data.at("id").AsInt())
+                .EndDict();
+            return;
+        }
+        writer.StartDict().Key("journeys").StartArray();
+        for (const auto& route : routes) {
+            // Каждый элемент Bus — одна посадка
+            const auto boardings = std::count_if(route.records.begin(), route.records.end(),
+                                                 [](const auto& record) { return record.is_bus; });
+            writer.StartDict().Key("items");
+            WriteRouteItems(route, writer);
+            writer
+                .Key("total_time").Value(route.travel_time)
+                .Key("transfers").Value(static_cast<int>(std::max<std::ptrdiff_t>(boardings - 1, 0)))
+            .EndDict();
+        }
+        writer
+            .EndArray()
+            .Key("request_id").Value(command_data.at("id").AsInt())
+        .EndDict();
+    }
+    std::optional<size_t> JsonReader::GetMaxTransfers(const json::Dict& command_data) const {
+        const auto it = command_data.find("max_transfers");
+        if (it == command_data.end()) {
+            return std::nullopt;
+        }
+        const int max_transfers = it->second.AsInt();
+        if (max_transfers < 0) {
+            throw std::invalid_argument("max_transfers should be non-negative");
+        }
+        return static_cast<size_t>(max_transfers);
+    }
+    void JsonReader::WriteRouteItems(const router::RoutingResult& route, json::Writer& writer) const {
+        auto items = writer.StartArray();
+        for (const auto& element : route.records) {
+            if (element.is_bus) { // Это автобусный сегмент
+                items.StartDict()
+                        .Key("bus").Value(element.name)
+                        .Key("span_count").Value(element.span_count)
+                        .Key("time").Value(element.time)
+                        .Key("type").Value("Bus")
+                    .EndDict();
+            } else { // Это ожидание на остановке
+                items.StartDict()
+                        .Key("stop_name").Value(element.name)
+                        .Key("time").Value(element.time)
+                        .Key("type").Value("Wait")
+                    .EndDict();
+            }
+        }
+        items.EndArray();
+    }
+    // Ответ — матрица времён в пути times[i][j] из from[i] в to[j]; null — пути нет
+    void JsonReader::HandleRouteMatrixRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const {
+        auto get_names = [](const json::Array& array) {
+            std::vector<std::string_view> names;
+            names.reserve(array.size());
+            for (const auto& name : array) {
+                names.push_back(name.AsString());
+            }
+            return names;
+        };
+        const auto times = handler.ComputeTravelTimes(get_names(command_data.at("from").AsArray()),
+                                                      get_names(command_data.at("to").AsArray()));
+        auto rows = writer.StartDict()
+                              .Key("request_id").Value(command_data.at("id").AsInt())
+                              .Key("times").StartArray();
+        for (const auto& times_row : times) {
+            auto row = rows.StartArray();
+            for (const auto& time : times_row) {
+                if (time) {
+                    row.Value(*time);
+                } else {
+                    row.Value(nullptr);
+                }
+            }
+            row.EndArray();
+        }
+        rows.EndArray().EndDict();
+    }
+    void JsonReader::HandleIsochroneRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const {
+        const auto stops = handler.ComputeIsochrone(command_data.at("from").AsString(),
+                                                    command_data.at("max_time").AsDouble());
+        if (!stops) {
+            writer.StartDict()
+                        .Key("error_message").Value("not found")
+                        .Key("request_id").Value(command_data.at("id").AsInt())
+                      .EndDict();
+            return;
+        }
+        auto items = writer.StartDict()
+                               .Key("request_id").Value(command_data.at("id").AsInt())
+                               .Key("stops").StartArray();
+        for (const auto& [name, time] : *stops) {
+            items.StartDict()
+                    .Key("stop_name").Value(name)
+                    .Key("time").Value(time)
+                .EndDict();
+        }
+        items.EndArray().EndDict();
+    }
+    void JsonReader::HandleMapRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const {
         std::ostringstream svg_output;
         handler.RenderMap(svg_output);
 
-        std::string map = svg_output.str();
-        builder.StartDict()
-                    .Key("map").Value(map)
+        writer.StartDict()
+                    .Key("map").Value(svg_output.view())
                     .Key("request_id").Value(command_data.at("id").AsInt())
                   .EndDict();
     }
 
-    void JsonReader::PrintResponse(request_handler::RequestHandler& handler) {
-        auto json_build = json::Builder{};
-        json_build.StartArray();
-        
-        auto requests = doc_.GetRoot().AsMap().at("stat_requests").AsArray();
-        for (const auto& req : requests) {
-            auto command = req.AsMap();
+    void JsonReader::PrintResponse(request_handler::RequestHandler& handler, std::ostream& output) {
+        json::ArrayPrinter printer(output, settings_.output_format);
+        AnswerAllRequests(doc_.GetRoot().AsMap().at("stat_requests").AsArray(), handler, printer);
+        printer.Finish();
+    }
 
-            if (command.at("type").AsString() == "Stop") {
-                HandleStopRequest(command, handler, json_build);
-            }
-            else if (command.at("type").AsString() == "Bus") {
-                HandleBusRequest(command, handler, json_build);
-            }
-            else if (command.at("type").AsString() == "Route") {
-                HandleRouteRequest(command, handler, json_build);
+    size_t JsonReader::GetRequestBatchSize() const {
+        return settings_.request_threads == 1 ? 1 : settings_.request_threads * REQUESTS_PER_THREAD;
+    }
+
+    void JsonReader::AnswerAllRequests(const json::Array& requests, request_handler::RequestHandler& handler,
+                                       json::ArrayPrinter& printer) const {
+        std::vector<const json::Dict*> batch;
+        for (const auto& request : requests) {
+            batch.push_back(&request.AsMap());
+            if (batch.size() == GetRequestBatchSize()) {
+                AnswerRequests(batch, handler, printer);
+                batch.clear();
             }
-            else {
-                HandleMapRequest(command, handler, json_build);
+        }
+        AnswerRequests(batch, handler, printer);
+    }
+
+    // Справочник, маршрутизатор и визуализатор после построения только читаются, поэтому запросы
+    // пачки независимы. Ответ каждого записывается в свой буфер, буферы выводятся по порядку
+    void JsonReader::AnswerRequests(std::span<const json::Dict* const> requests,
+                                    request_handler::RequestHandler& handler, json::ArrayPrinter& printer) const {
+        if (settings_.request_threads == 1) {
+            std::string response;
+            for (const json::Dict* request : requests) {
+                response.clear();
+                HandleRequest(*request, handler, response);
+                printer.PrintSerialized(response);
             }
+            return;
+        }
+        std::vector<std::string> responses(requests.size());
+        parallel::ForEachIndex(requests.size(), settings_.request_threads, [&](size_t index, size_t) {
+            HandleRequest(*requests[index], handler, responses[index]);
+        });
+        for (const auto& response : responses) {
+            printer.PrintSerialized(response);
+        }
+    }
+
+    // Ответ пишется сразу текстом, с отступом элемента массива ответов
+    void JsonReader::HandleRequest(const json::Dict& command, request_handler::RequestHandler& handler,
+                                   std::string& response) const {
+        json::Writer writer(response, settings_.output_format, json::Serializer::INDENT_STEP);
+        const json::String& type = command.at("type").AsString();
+        if (type == "Stop") {
+            HandleStopRequest(command, handler, writer);
+        }
+        else if (type == "Bus") {
+            HandleBusRequest(command, handler, writer);
+        }
+        else if (type == "Route") {
+            HandleRouteRequest(command, handler, writer);
+        }
+        else if (type == "RouteMatrix") {
+            HandleRouteMatrixRequest(command, handler, writer);
+        }
+        else if (type == "Isochrone") {
+            HandleIsochroneRequest(command, handler, writer);
+        }
+        else {
+            HandleMapRequest(command, handler, writer);
         }
-        json::Print(
-            json::Document{json_build.EndArray().Build()}
-            , std::cout
-          );
+        writer.Finish();
     }
 
     std::vector<std::string_view> JsonReader::GetRoute(const json::Array& stops, bool is_roundtrip) {
@@ -170,37 +596,61 @@ namespace json_reader {
 
     void JsonReader::AddBuses(const json::Array& array) {
         for (auto& dict : array) {
-            if ( auto element = dict.AsMap(); element.at("type").AsString() == "Bus") {
+            if (const auto& element = dict.AsMap(); element.at("type").AsString() == "Bus") {
                 std::vector<std::string_view> bus_route = GetRoute(element.at("stops").AsArray(),
                                                                    element.at("is_roundtrip").AsBool());
                 
-                std::vector<domain::Stop*> bus_stops;
+                std::vector<domain::StopId> bus_stops;
                 for (const auto stops_name : bus_route) {
-                    bus_stops.push_back(catalogue_.FindStopByName(stops_name));
+                    bus_stops.push_back(catalogue_.FindStopByName(stops_name)->id);
                 }
 
-                domain::Bus bus = {element.at("is_roundtrip").AsBool(), element.at("name").AsString(), bus_stops};
-                catalogue_.AddBus(std::move(bus));
+                catalogue_.AddBus(element.at("name").AsString(), element.at("is_roundtrip").AsBool(), bus_stops,
+                                  GetDepartures(element));
             }
         }
     }
 
+    // Расписание задаётся списком "departures" или интервалом движения "headway":
+    // {"first_departure": ..., "last_departure": ..., "interval": ...}, всё в минутах от начала суток
+    std::vector<double> JsonReader::GetDepartures(const json::Dict& bus) const {
+        std::vector<double> departures;
+        if (const auto it = bus.find("departures"); it != bus.end()) {
+            for (const auto& departure : it->second.AsArray()) {
+                departures.push_back(departure.AsDouble());
+            }
+            std::sort(departures.begin(), departures.end());
+        }
+        else if (const auto it = bus.find("headway"); it != bus.end()) {
+            const auto& headway = it->second.AsMap();
+            const double first = headway.at("first_departure").AsDouble();
+            const double last = headway.at("last_departure").AsDouble();
+            const double interval = headway.at("interval").AsDouble();
+            if (!(interval > 0.)) {
+                throw std::invalid_argument("Headway interval should be positive");
+            }
+            for (int trip = 0; first + trip * interval <= last; ++trip) {
+                departures.push_back(first + trip * interval);
+            }
+        }
+        return departures;
+    }
+
     void JsonReader::AddStops(const json::Array& array) {
         std::unordered_map<std::string, std::vector<std::pair<int, std::string>>> stops_to_distances;
         for (auto& dict : array) {
-            if ( auto element = dict.AsMap(); element.at("type").AsString() == "Stop") {
-                domain::Stop stop = {element.at("name").AsString(), 
-                                     geo::Coordinates{element.at("latitude").AsDouble(),
-                                                      element.at("longitude").AsDouble()}};
+            if (const auto& element = dict.AsMap(); element.at("type").AsString() == "Stop") {
+                const std::string_view stop_name = element.at("name").AsString();
 
                 std::vector<std::pair<int, std::string>> distances;                            
                 for (auto& stop_dist : element.at("road_distances").AsMap()) {
-                    distances.push_back(std::make_pair(stop_dist.second.AsInt(), stop_dist.first));
+                    distances.push_back(std::make_pair(stop_dist.second.AsInt(), std::string(stop_dist.first)));
                 }
                 if(!distances.empty()) {
-                    stops_to_distances[stop.stop_name] = std::move(distances);
+                    stops_to_distances[std::string(stop_name)] = std::move(distances);
                 }
-                catalogue_.AddStop(std::move(stop));
+                catalogue_.AddStop(stop_name, geo::Coordinates{element.at("latitude").AsDouble(),
+                                                               element.at("longitude").AsDouble()});
             }
         }
         AddAllDistances(std::move(stops_to_distances));
@@ -211,8 +661,11 @@ namespace json_reader {
     }
 
     renderer::Settings JsonReader::GetRenderSettings() {
+        return GetRenderSettings(doc_.GetRoot().AsMap().at("render_settings").AsMap());
+    }
+
+    renderer::Settings JsonReader::GetRenderSettings(const json::Dict& dict) const {
         renderer::Settings settings;
-        const json::Dict& dict =  doc_.GetRoot().AsMap().at("render_settings").AsMap();
         settings.width = dict.at("width").AsDouble();
         settings.height = dict.at("height").AsDouble();
         settings.padding = dict.at("padding").AsDouble();
@@ -232,15 +685,48 @@ namespace json_reader {
     }
 
     router::Settings JsonReader::GetRoutingSettings() {
+        return GetRoutingSettings(doc_.GetRoot().AsMap().at("routing_settings").AsMap());
+    }
+
+    router::Settings JsonReader::GetRoutingSettings(const json::Dict& dict) const {
         router::Settings settings;
-        const json::Dict& dict = doc_.GetRoot().AsMap().at("routing_settings").AsMap();
         settings.bus_velocity = dict.at("bus_velocity").AsDouble();
         settings.bus_wait_time = dict.at("bus_wait_time").AsInt();
+        if (const auto it = dict.find("router_mode"); it != dict.end()) {
+            settings.router_mode = GetRouterMode(it->second);
+        }
+        if (const auto it = dict.find("preprocessing_threads"); it != dict.end()) {
+            const int preprocessing_threads = it->second.AsInt();
+            if (preprocessing_threads < 0) {
+                throw std::invalid_argument("preprocessing_threads should be non-negative");
+            }
+            settings.preprocessing_threads = static_cast<size_t>(preprocessing_threads);
+        }
         return settings;
     }
 
+    graph::RouterMode JsonReader::GetRouterMode(const json::Node& value) const {
+        const std::string_view mode = value.AsString();
+        if (mode == "all_pairs") {
+            return graph::RouterMode::ALL_PAIRS;
+        }
+        if (mode == "all_pairs_dijkstra") {
+            return graph::RouterMode::ALL_PAIRS_DIJKSTRA;
+        }
+        if (mode == "dijkstra") {
+            return graph::RouterMode::DIJKSTRA;
+        }
+        if (mode == "bidirectional_astar") {
+            return graph::RouterMode::BIDIRECTIONAL_ASTAR;
+        }
+        if (mode == "contraction_hierarchy") {
+            return graph::RouterMode::CONTRACTION_HIERARCHY;
+        }
+        throw std::invalid_argument("Unknown router_mode: " + std::string(mode));
+    }
+
 
-    std::variant<std::string, std::vector<double>> JsonReader::GetColor(const json::Node& value) {
+    std::variant<std::string, std::vector<double>> JsonReader::GetColor(const json::Node& value) const {
         std::variant<std::string, std::vector<double>> color;
         if (value.IsArray()) {
             std::vector<double> rgb;
@@ -259,12 +745,12 @@ namespace json_reader {
             }
         }
         else if (value.IsString()) {
-            color = value.AsString();
+            color = std::string(value.AsString());
         }
         return color;
     }
 
-    std::vector<std::variant<std::string, std::vector<double>>> JsonReader::GetColorPalette(const json::Array& array) {
+    std::vector<std::variant<std::string, std::vector<double>>> JsonReader::GetColorPalette(const json::Array& array) const {
         std::vector<std::variant<std::string, std::vector<double>>> colors;
         for (auto& color : array) {
             colors.push_back(GetColor(color));
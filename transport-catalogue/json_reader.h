@@ -1,37 +1,94 @@
 #pragma once
 #include <algorithm>
-#include <istream>
+#include <iostream>
+#include <span>
+#include <string_view>
+#include <variant>
 #include "json.h"
 #include "json_builder.h"
+#include "json_writer.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 #include "request_handler.h"
 #include "map_renderer.h"
 
 namespace json_reader {
+    // Способ чтения входного документа
+    enum class InputMode {
+        DOCUMENT,   // документ разбирается целиком, справочник строится по нему в BuildBase
+        STREAM      // ProcessStream: справочник заполняется по ходу разбора, ответы выводятся по мере чтения запросов
+    };
+
+    struct Settings {
+        InputMode input_mode = InputMode::DOCUMENT;
+        // Число потоков для ответов на stat_requests, 0 — по числу ядер
+        size_t request_threads = 1;
+        json::PrintFormat output_format = json::PrintFormat::PRETTY;
+    };
+
     class JsonReader {
     public:
-        explicit JsonReader(std::istream& input);
+        explicit JsonReader(std::istream& input, Settings settings = {});
+        // Разбор на месте из буфера в памяти, например из отображённого файла.
+        // Буфер должен жить дольше JsonReader
+        explicit JsonReader(std::string_view input, Settings settings = {});
+        // BuildBase, GetRenderSettings, GetRoutingSettings и PrintResponse — для режима DOCUMENT
         void BuildBase();
         const transport_catalogue::TransportCatalogue& GetCatalogue() const;
-        void PrintResponse(request_handler::RequestHandler& handler);
+        // Ответ на каждый запрос выводится сразу, массив ответов целиком не строится
+        void PrintResponse(request_handler::RequestHandler& handler, std::ostream& output = std::cout);
         renderer::Settings GetRenderSettings();
 
         router::Settings GetRoutingSettings();
+        // Режим STREAM: разбор входа, построение справочника, маршрутизатора и ответы на stat_requests.
+        // Если раздел stat_requests идёт после base_requests, render_settings и routing_settings,
+        // ответ на запрос выводится сразу после его чтения, иначе запросы ждут конца документа
+        void ProcessStream(std::ostream& output);
 
     private:
+        class StreamLoader;
+
+        using Input = std::variant<std::istream*, std::string_view>;
+
+        JsonReader(Input input, Settings settings);
+        static json::Document LoadDocument(Input input);
+
+        // Сколько запросов на поток собирается в одну пачку при ответах в несколько потоков
+        static constexpr size_t REQUESTS_PER_THREAD = 64;
+
+        void CheckMode(InputMode mode) const;
+        renderer::Settings GetRenderSettings(const json::Dict& dict) const;
+        router::Settings GetRoutingSettings(const json::Dict& dict) const;
         std::string EscapeString(const std::string& str) const;
-        std::variant<std::string, std::vector<double>> GetColor(const json::Node& value);
-        std::vector<std::variant<std::string, std::vector<double>>> GetColorPalette(const json::Array& array);
+        std::variant<std::string, std::vector<double>> GetColor(const json::Node& value) const;
+        std::vector<std::variant<std::string, std::vector<double>>> GetColorPalette(const json::Array& array) const;
+        graph::RouterMode GetRouterMode(const json::Node& value) const;
         std::vector<std::string_view> GetRoute(const json::Array& stops, bool is_roundtrip);
+        std::vector<double> GetDepartures(const json::Dict& bus) const;
         void AddBuses(const json::Array& array);
         void AddStops(const json::Array& array);
         void AddAllDistances(std::unordered_map<std::string, std::vector<std::pair<int, std::string>>> distances);
-        void HandleStopRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Builder& builder) const;
-        void HandleBusRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Builder& builder) const;
-        void HandleMapRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Builder& builder) const;
-        void HandleRouteRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Builder& builder) const;
+        size_t GetRequestBatchSize() const;
+        void AnswerAllRequests(const json::Array& requests, request_handler::RequestHandler& handler,
+                               json::ArrayPrinter& printer) const;
+        void AnswerRequests(std::span<const json::Dict* const> requests, request_handler::RequestHandler& handler,
+                            json::ArrayPrinter& printer) const;
+        void HandleRequest(const json::Dict& command_data, request_handler::RequestHandler& handler,
+                           std::string& response) const;
+        void HandleStopRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const;
+        void HandleBusRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const;
+        void HandleMapRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const;
+        void HandleRouteRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const;
+        void HandleRouteMatrixRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const;
+        void HandleIsochroneRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const;
+        void HandleParetoRouteRequest(const json::Dict& command_data, request_handler::RequestHandler& handler, json::Writer& writer) const;
+        std::optional<size_t> GetMaxTransfers(const json::Dict& command_data) const;
+        void WriteRouteItems(const router::RoutingResult& route, json::Writer& writer) const;
 
+        Settings settings_;
+        Input input_;
+        // Документ объявлен до справочника и уничтожается после него: в режиме DOCUMENT справочник
+        // не копирует имена остановок и автобусов, а ссылается на строки документа
         json::Document doc_;
         transport_catalogue::TransportCatalogue catalogue_;
     };
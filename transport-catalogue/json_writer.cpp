@@ -0,0 +1,154 @@
+#include "json_writer.h"
+
+namespace json {
+
+    Writer::Writer(std::string& buffer, PrintFormat format, size_t indent)
+        : serializer_(buffer, nullptr, format)
+        , indent_(indent) {
+    }
+
+    void Writer::Finish() const {
+        if (!complete_) {
+            throw std::logic_error("Wrong JSON structure");
+        }
+    }
+
+    Writer::KeyItemContext Writer::Key(std::string_view key) {
+        if (complete_) {
+            throw std::logic_error("Cannot modify already built JSON");
+        }
+        if (containers_stack_.empty() || !containers_stack_.back().is_dict || key_written_) {
+            throw std::logic_error("Wrong Key() usage");
+        }
+        Container& dict = containers_stack_.back();
+        serializer_.StartElement(dict.empty, GetIndent());
+        dict.empty = false;
+        serializer_.WriteString(key);
+        serializer_.WriteColon();
+        key_written_ = true;
+        return KeyItemContext(*this);
+    }
+
+    Writer& Writer::Value(std::nullptr_t) {
+        BeforeValue();
+        serializer_.WriteNull();
+        AfterValue();
+        return *this;
+    }
+
+    Writer& Writer::Value(bool value) {
+        BeforeValue();
+        serializer_.WriteScalar(value);
+        AfterValue();
+        return *this;
+    }
+
+    Writer& Writer::Value(int value) {
+        BeforeValue();
+        serializer_.WriteScalar(value);
+        AfterValue();
+        return *this;
+    }
+
+    Writer& Writer::Value(double value) {
+        BeforeValue();
+        serializer_.WriteScalar(value);
+        AfterValue();
+        return *this;
+    }
+
+    Writer& Writer::Value(std::string_view value) {
+        BeforeValue();
+        serializer_.WriteString(value);
+        AfterValue();
+        return *this;
+    }
+
+    Writer& Writer::Value(const std::string& value) {
+        return Value(std::string_view(value));
+    }
+
+    Writer& Writer::Value(const String& value) {
+        return Value(std::string_view(value));
+    }
+
+    Writer& Writer::Value(const char* value) {
+        return Value(std::string_view(value));
+    }
+
+    Writer& Writer::Value(const Node& node) {
+        BeforeValue();
+        serializer_.WriteNode(node, GetIndent());
+        AfterValue();
+        return *this;
+    }
+
+    Writer::DictItemContext Writer::StartDict() {
+        BeforeValue();
+        serializer_.StartContainer('{');
+        containers_stack_.push_back(Container{.is_dict = true});
+        return DictItemContext(*this);
+    }
+
+    Writer::ArrayItemContext Writer::StartArray() {
+        BeforeValue();
+        serializer_.StartContainer('[');
+        containers_stack_.push_back(Container{.is_dict = false});
+        return ArrayItemContext(*this);
+    }
+
+    Writer& Writer::EndDict() {
+        EndContainer(true);
+        return *this;
+    }
+
+    Writer& Writer::EndArray() {
+        EndContainer(false);
+        return *this;
+    }
+
+    // Элемент массива начинается сразу, значение словаря — после уже записанного ключа
+    void Writer::BeforeValue() {
+        if (complete_) {
+            throw std::logic_error("Cannot modify already built JSON");
+        }
+        if (containers_stack_.empty()) {
+            return;
+        }
+        Container& container = containers_stack_.back();
+        if (container.is_dict) {
+            if (!key_written_) {
+                throw std::logic_error("Value() must follow Key() inside a dictionary");
+            }
+            key_written_ = false;
+        } else {
+            serializer_.StartElement(container.empty, GetIndent());
+            container.empty = false;
+        }
+    }
+
+    void Writer::AfterValue() {
+        complete_ = containers_stack_.empty();
+    }
+
+    void Writer::EndContainer(bool is_dict) {
+        if (complete_) {
+            throw std::logic_error("Cannot modify already built JSON");
+        }
+        if (containers_stack_.empty() || key_written_) {
+            throw std::logic_error(is_dict ? "Wrong EndDict() usage" : "Wrong EndArray() usage");
+        }
+        if (containers_stack_.back().is_dict != is_dict) {
+            throw std::logic_error(is_dict ? "Wrong container end. Should be Dict"
+                                           : "Wrong container end. Should be Array");
+        }
+        containers_stack_.pop_back();
+        serializer_.EndContainer(is_dict ? '}' : ']', GetIndent());
+        AfterValue();
+    }
+
+    // Отступ элементов текущего контейнера; вне контейнеров — отступ самого значения
+    size_t Writer::GetIndent() const {
+        return indent_ + containers_stack_.size() * Serializer::INDENT_STEP;
+    }
+} // namespace json
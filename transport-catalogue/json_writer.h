@@ -0,0 +1,115 @@
+#pragma once
+
+#include "json.h"
+
+namespace json {
+
+    // Потоковая запись JSON с тем же порядком вызовов, что у Builder, но без дерева узлов:
+    // каждый вызов сразу дописывает текст в буфер. Ключи словаря выводятся в порядке вызовов Key,
+    // а не по алфавиту, как у Dict. indent — отступ строки, на которой начинается значение,
+    // он нужен, чтобы значение можно было вставить внутрь внешнего массива
+    class Writer {
+    private:
+        class BaseContext;
+        class DictItemContext;
+        class KeyItemContext;
+        class ArrayItemContext;
+    public:
+        explicit Writer(std::string& buffer, PrintFormat format = PrintFormat::PRETTY, size_t indent = 0);
+
+        // Проверяет, что значение записано целиком
+        void Finish() const;
+        KeyItemContext Key(std::string_view key);
+        Writer& Value(std::nullptr_t);
+        Writer& Value(bool value);
+        Writer& Value(int value);
+        Writer& Value(double value);
+        Writer& Value(std::string_view value);
+        Writer& Value(const std::string& value);
+        Writer& Value(const String& value);
+        Writer& Value(const char* value);
+        Writer& Value(const Node& node);
+        DictItemContext StartDict();
+        ArrayItemContext StartArray();
+        Writer& EndDict();
+        Writer& EndArray();
+
+    private:
+        struct Container {
+            bool is_dict;
+            bool empty = true;
+        };
+
+        void BeforeValue();
+        void AfterValue();
+        void EndContainer(bool is_dict);
+        size_t GetIndent() const;
+
+        Serializer serializer_;
+        size_t indent_;
+        std::vector<Container> containers_stack_;
+        bool key_written_ = false;
+        bool complete_ = false;
+
+        class BaseContext {
+            public:
+                BaseContext(Writer& writer) : writer_(writer) {}
+                void Finish() {
+                    writer_.Finish();
+                }
+                KeyItemContext Key(std::string_view key) {
+                    return writer_.Key(key);
+                }
+                template <typename T>
+                BaseContext Value(T&& value) {
+                    return writer_.Value(std::forward<T>(value));
+                }
+                DictItemContext StartDict() {
+                    return writer_.StartDict();
+                }
+                ArrayItemContext StartArray() {
+                    return writer_.StartArray();
+                }
+                BaseContext EndDict() {
+                    return writer_.EndDict();
+                }
+                BaseContext EndArray() {
+                    return writer_.EndArray();
+                }
+            private:
+                Writer& writer_;
+        };
+
+        class DictItemContext : public BaseContext {
+        public:
+            DictItemContext(BaseContext base) : BaseContext(base) {}
+            void Finish() = delete;
+            template <typename T>
+            BaseContext Value(T&& value) = delete;
+            BaseContext EndArray() = delete;
+            DictItemContext StartDict() = delete;
+            ArrayItemContext StartArray() = delete;
+        };
+
+        class KeyItemContext : public BaseContext {
+        public:
+            KeyItemContext(BaseContext base) : BaseContext(base) {}
+            void Finish() = delete;
+            DictItemContext Key(std::string_view key) = delete;
+            BaseContext EndDict() = delete;
+            BaseContext EndArray() = delete;
+            template <typename T>
+            DictItemContext Value(T&& value) { return BaseContext::Value(std::forward<T>(value)); }
+        };
+
+        class ArrayItemContext : public BaseContext {
+        public:
+            ArrayItemContext(BaseContext base) : BaseContext(base) {}
+            template <typename T>
+            ArrayItemContext Value(T&& value) { return BaseContext::Value(std::forward<T>(value)); }
+            void Finish() = delete;
+            KeyItemContext Key(std::string_view key) = delete;
+            BaseContext EndDict() = delete;
+        };
+    };
+} // namespace json
@@ -1,14 +1,71 @@
+#include <charconv>
+#include <cstring>
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <system_error>
 
 #include "json.h"
 #include "json_reader.h"
+#include "mapped_file.h"
 #include "request_handler.h"
 #include "map_renderer.h"
 
+using namespace std::literals;
 
-int main() {
-    {
-        json_reader::JsonReader reader(std::cin);
+// Параметры командной строки:
+//   --stream     справочник заполняется по ходу чтения входа, без полного документа в памяти,
+//                ответы на запросы выводятся по мере их чтения
+//   --threads N  число потоков для ответов на stat_requests, 0 — по числу ядер (по умолчанию 1)
+//   --compact    ответ без пробелов и переводов строк
+//   --input PATH вход читается из файла, отображённого в память, а не из стандартного ввода.
+//                Строки документа всё равно копируются в его арену, названия в справочнике
+//                ссылаются на эти копии, а не на отображение
+int main(int argc, char* argv[]) {
+    json_reader::Settings settings;
+    const char* input_path = nullptr;
+    for (int arg = 1; arg < argc; ++arg) {
+        if (argv[arg] == "--stream"sv) {
+            settings.input_mode = json_reader::InputMode::STREAM;
+        }
+        else if (argv[arg] == "--compact"sv) {
+            settings.output_format = json::PrintFormat::COMPACT;
+        }
+        else if (argv[arg] == "--input"sv && arg + 1 < argc) {
+            input_path = argv[++arg];
+        }
+        else if (argv[arg] == "--threads"sv && arg + 1 < argc) {
+            const char* value = argv[++arg];
+            const char* value_end = value + std::strlen(value);
+            if (const auto [ptr, ec] = std::from_chars(value, value_end, settings.request_threads);
+                ec != std::errc{} || ptr != value_end) {
+                std::cerr << "Invalid number of threads: " << value << std::endl;
+                return 1;
+            }
+        }
+        else {
+            std::cerr << "Unknown option: " << argv[arg] << std::endl;
+            return 1;
+        }
+    }
+
+    std::optional<io::MappedFile> input_file;
+    if (input_path != nullptr) {
+        try {
+            input_file.emplace(input_path);
+        }
+        catch (const std::system_error& error) {
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+    }
+    json_reader::JsonReader reader = input_file ? json_reader::JsonReader(input_file->GetContent(), settings)
+                                                : json_reader::JsonReader(std::cin, settings);
+
+    if (settings.input_mode == json_reader::InputMode::STREAM) {
+        reader.ProcessStream(std::cout);
+    }
+    else {
         reader.BuildBase();
         renderer::MapRenderer renderer(reader.GetRenderSettings());
         router::TransportRouter router(reader.GetCatalogue(), reader.GetRoutingSettings());
@@ -5,9 +5,10 @@ namespace renderer {
     const Settings& MapRenderer::GetSettings() const {
         return settings_;
     }
-    void MapRenderer::Render(std::ostream &out, const SphereProjector proj, std::set<const Bus*, BusComparator> buses, std::set<Stop*, StopComparator> stops) const {
+    void MapRenderer::Render(std::ostream &out, const SphereProjector proj, const transport_catalogue::TransportCatalogue& catalogue,
+                             std::set<const Bus*, BusComparator> buses, std::set<const Stop*, StopComparator> stops) const {
         svg::Document doc;
-        AddBusesToMap(doc, proj, buses);
+        AddBusesToMap(doc, proj, catalogue, buses);
         AddStopsToMap(doc, proj, stops);
         AddStopLabelsToMap(doc, proj, stops);
         doc.Render(out);
@@ -67,7 +68,7 @@ namespace renderer {
         return settings_.stop_radius;
     }
 
-    void MapRenderer::AddStopLabelsToMap(svg::Document& doc, const SphereProjector& proj, std::set<Stop*, StopComparator>& stops) const {
+    void MapRenderer::AddStopLabelsToMap(svg::Document& doc, const SphereProjector& proj, std::set<const Stop*, StopComparator>& stops) const {
         auto color_stop = GetUnderlayerColor();
         auto stop_label = svg::Text()
                                     .SetOffset(GetStopLabelOffset())
@@ -85,15 +86,15 @@ namespace renderer {
 
         for (const auto stop : stops) {
             stop_label_base.SetPosition(proj(stop->coordinates))
-                           .SetData(stop->stop_name);
+                           .SetData(std::string(stop->stop_name));
             stop_label_text.SetPosition(proj(stop->coordinates))
-                           .SetData(stop->stop_name);
+                           .SetData(std::string(stop->stop_name));
             doc.Add(stop_label_base);
             doc.Add(stop_label_text);
         }
     }
 
-    void MapRenderer::AddStopsToMap(svg::Document& doc, const SphereProjector& proj, std::set<domain::Stop*, domain::StopComparator>& stops) const {
+    void MapRenderer::AddStopsToMap(svg::Document& doc, const SphereProjector& proj, std::set<const domain::Stop*, domain::StopComparator>& stops) const {
         auto stop_circle = svg::Circle().SetRadius(GetStopRadius())
                                         .SetFillColor("white");
         for (const auto stop : stops) {
@@ -103,7 +104,8 @@ namespace renderer {
     }
 
 
-    void MapRenderer::AddBusesLines(svg::Document& doc, const SphereProjector& proj, std::set<const domain::Bus*, domain::BusComparator>& buses) const {
+    void MapRenderer::AddBusesLines(svg::Document& doc, const SphereProjector& proj, const transport_catalogue::TransportCatalogue& catalogue,
+                                        std::set<const domain::Bus*, domain::BusComparator>& buses) const {
         svg::Polyline line;
         size_t count = 0;
         size_t color_number = GetColorsCount();
@@ -120,7 +122,7 @@ namespace renderer {
                                             .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
                                             .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
             for (size_t stop = 0; stop < bus->stops.size(); ++stop) {
-                base_line.AddPoint(proj(bus->stops[stop]->coordinates));
+                base_line.AddPoint(proj(catalogue.GetStop(bus->stops[stop]).coordinates));
             }
 
             ++count;
@@ -128,7 +130,8 @@ namespace renderer {
         }
     }
 
-    void MapRenderer::AddBusesLabels(svg::Document& doc, const SphereProjector& proj, std::set<const domain::Bus*, domain::BusComparator>& buses) const {
+    void MapRenderer::AddBusesLabels(svg::Document& doc, const SphereProjector& proj, const transport_catalogue::TransportCatalogue& catalogue,
+                                         std::set<const domain::Bus*, domain::BusComparator>& buses) const {
         size_t count = 0;
         size_t color_number = GetColorsCount();
 
@@ -145,7 +148,7 @@ namespace renderer {
                                     .SetFontSize(GetBusLabelFontSize())
                                     .SetFontFamily("Verdana")
                                     .SetFontWeight("bold")
-                                    .SetData(bus->bus_name); 
+                                    .SetData(std::string(bus->bus_name)); 
 
             svg::Color underlayer_color = GetUnderlayerColor();  
 
@@ -157,14 +160,14 @@ namespace renderer {
 
             auto bus_name_text = svg::Text(label).SetFillColor(color);
 
-            bus_name_base.SetPosition(proj(bus->stops[0]->coordinates));
-            bus_name_text.SetPosition(proj(bus->stops[0]->coordinates));
+            bus_name_base.SetPosition(proj(catalogue.GetStop(bus->stops[0]).coordinates));
+            bus_name_text.SetPosition(proj(catalogue.GetStop(bus->stops[0]).coordinates));
             doc.Add(bus_name_base);
             doc.Add(bus_name_text);
             if (!bus->is_roundtrip) {
                 if(bus->stops[bus->stops.size()/2] != bus->stops[0]) {
-                    bus_name_base.SetPosition(proj(bus->stops[bus->stops.size()/2]->coordinates));
-                    bus_name_text.SetPosition(proj(bus->stops[bus->stops.size()/2]->coordinates));
+                    bus_name_base.SetPosition(proj(catalogue.GetStop(bus->stops[bus->stops.size()/2]).coordinates));
+                    bus_name_text.SetPosition(proj(catalogue.GetStop(bus->stops[bus->stops.size()/2]).coordinates));
                     doc.Add(bus_name_base);
                     doc.Add(bus_name_text);
                 }
@@ -172,8 +175,9 @@ namespace renderer {
             ++count;
         }
     }
-    void MapRenderer::AddBusesToMap(svg::Document& doc, const SphereProjector& proj, std::set<const Bus*, BusComparator>& buses) const {
-        AddBusesLines(doc, proj, buses);
-        AddBusesLabels(doc, proj, buses);
+    void MapRenderer::AddBusesToMap(svg::Document& doc, const SphereProjector& proj, const transport_catalogue::TransportCatalogue& catalogue,
+                                        std::set<const Bus*, BusComparator>& buses) const {
+        AddBusesLines(doc, proj, catalogue, buses);
+        AddBusesLabels(doc, proj, catalogue, buses);
     }
 } // namespace renderer
\ No newline at end of file
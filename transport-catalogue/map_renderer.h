@@ -5,6 +5,7 @@
 #include "geo.h"
 #include "domain.h"
 #include "svg.h"
+#include "transport_catalogue.h"
 
 namespace renderer {
     inline const double EPSILON = 1e-6;
@@ -94,7 +95,8 @@ namespace renderer {
         }
 
         const Settings& GetSettings() const;
-        void Render(std::ostream &out, const SphereProjector proj, std::set<const domain::Bus*, domain::BusComparator> buses, std::set<domain::Stop*, domain::StopComparator> stops) const;
+        void Render(std::ostream &out, const SphereProjector proj, const transport_catalogue::TransportCatalogue& catalogue,
+                    std::set<const domain::Bus*, domain::BusComparator> buses, std::set<const domain::Stop*, domain::StopComparator> stops) const;
         svg::Color GetNeededColor(std::variant<std::string, std::vector<double>> color) const;
         svg::Rgb GetRgbColor(std::vector<double> color) const;
         svg::Rgba GetRgbaColor(std::vector<double> color) const;
@@ -108,11 +110,14 @@ namespace renderer {
         svg::Color GetUnderlayerColor() const;
         double GetUnderlayerWidth() const;
         double GetStopRadius() const;
-        void AddStopLabelsToMap(svg::Document& doc, const SphereProjector& proj, std::set<domain::Stop*, domain::StopComparator>& stops) const;
-        void AddStopsToMap(svg::Document& doc, const SphereProjector& proj, std::set<domain::Stop*, domain::StopComparator>& stops) const;
-        void AddBusesLines(svg::Document& doc, const SphereProjector& proj, std::set<const domain::Bus*, domain::BusComparator>& buses) const;
-        void AddBusesLabels(svg::Document& doc, const SphereProjector& proj, std::set<const domain::Bus*, domain::BusComparator>& buses) const;
-        void AddBusesToMap(svg::Document& doc, const SphereProjector& proj, std::set<const domain::Bus*, domain::BusComparator>& buses) const;
+        void AddStopLabelsToMap(svg::Document& doc, const SphereProjector& proj, std::set<const domain::Stop*, domain::StopComparator>& stops) const;
+        void AddStopsToMap(svg::Document& doc, const SphereProjector& proj, std::set<const domain::Stop*, domain::StopComparator>& stops) const;
+        void AddBusesLines(svg::Document& doc, const SphereProjector& proj, const transport_catalogue::TransportCatalogue& catalogue,
+                           std::set<const domain::Bus*, domain::BusComparator>& buses) const;
+        void AddBusesLabels(svg::Document& doc, const SphereProjector& proj, const transport_catalogue::TransportCatalogue& catalogue,
+                            std::set<const domain::Bus*, domain::BusComparator>& buses) const;
+        void AddBusesToMap(svg::Document& doc, const SphereProjector& proj, const transport_catalogue::TransportCatalogue& catalogue,
+                           std::set<const domain::Bus*, domain::BusComparator>& buses) const;
 
     private:
         Settings settings_;
@@ -0,0 +1,54 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace io {
+    namespace {
+        std::system_error MakeError(const std::string& message) {
+            return std::system_error(errno, std::generic_category(), message);
+        }
+    } // namespace
+
+    MappedFile::MappedFile(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw MakeError("Cannot open " + path);
+        }
+        struct stat file_stat {};
+        if (::fstat(fd, &file_stat) == -1) {
+            const auto error = MakeError("Cannot stat " + path);
+            ::close(fd);
+            throw error;
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if (size_ > 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                const auto error = MakeError("Cannot map " + path);
+                ::close(fd);
+                throw error;
+            }
+            // Вход разбирается один раз от начала до конца
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(data);
+        }
+        // Отображение остаётся действительным и после закрытия дескриптора
+        ::close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    std::string_view MappedFile::GetContent() const {
+        return {data_, size_};
+    }
+} // namespace io
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace io {
+    // Файл, отображённый в память только для чтения. Содержимое не копируется: страницы
+    // подгружаются при первом обращении. Пустой файл не отображается, его содержимое — пустая строка
+    class MappedFile {
+    public:
+        // Ошибка открытия или отображения — std::system_error
+        explicit MappedFile(const std::string& path);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        std::string_view GetContent() const;
+
+    private:
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+    };
+} // namespace io
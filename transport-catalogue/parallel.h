@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Число потоков по умолчанию: 0 в настройках означает «по числу ядер»
+inline size_t ResolveThreadCount(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    return thread_count;
+}
+
+// Вызывает function(index, worker) для каждого index из [0, count) на thread_count потоках.
+// worker — номер потока в [0, thread_count), по нему удобно выбирать рабочие буферы потока.
+// Индексы раздаются блоками через общий атомарный счётчик, поэтому неравномерная по времени
+// работа распределяется между потоками сама. Первое исключение из потоков пробрасывается наружу.
+template <typename Function>
+void ForEachIndex(size_t count, size_t thread_count, Function function) {
+    thread_count = std::min(ResolveThreadCount(thread_count), std::max<size_t>(count, 1));
+    if (thread_count == 1) {
+        for (size_t index = 0; index < count; ++index) {
+            function(index, size_t{0});
+        }
+        return;
+    }
+
+    const size_t chunk_size = std::max<size_t>(1, count / (thread_count * 16));
+    std::atomic<size_t> next_index{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto work = [&](size_t worker) {
+        try {
+            for (size_t begin = next_index.fetch_add(chunk_size); begin < count;
+                 begin = next_index.fetch_add(chunk_size)) {
+                const size_t end = std::min(begin + chunk_size, count);
+                for (size_t index = begin; index < end; ++index) {
+                    function(index, worker);
+                }
+            }
+        } catch (...) {
+            std::lock_guard lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next_index = count;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    auto join_all = [&threads] {
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    };
+    try {
+        for (size_t worker = 1; worker < thread_count; ++worker) {
+            threads.emplace_back(work, worker);
+        }
+    } catch (...) {
+        // Поток не создан: уже запущенные доделывают взятые блоки и останавливаются,
+        // иначе деструктор std::thread у присоединяемого потока вызвал бы std::terminate
+        next_index = count;
+        join_all();
+        throw;
+    }
+    work(0);
+    join_all();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace parallel
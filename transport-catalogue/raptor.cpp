@@ -0,0 +1,165 @@
+#include "raptor.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace router {
+    namespace {
+        constexpr double INFINITE_TIME = std::numeric_limits<double>::infinity();
+    } // namespace
+
+    RaptorRouter::RaptorRouter(const transport_catalogue::TransportCatalogue& catalogue,
+                               const std::vector<const domain::Stop*>& stops,
+                               const std::vector<const domain::Bus*>& buses,
+                               double bus_velocity, int bus_wait_time) {
+        // Номера остановок в справочнике -> номера в stops
+        std::vector<uint32_t> stop_ids(catalogue.GetStopCount());
+        for (uint32_t stop_id = 0; stop_id < stops.size(); ++stop_id) {
+            stop_ids[stops[stop_id]->id] = stop_id;
+        }
+
+        bus_offsets_.reserve(buses.size() + 1);
+        bus_offsets_.push_back(0);
+        for (uint32_t bus_id = 0; bus_id < buses.size(); ++bus_id) {
+            const auto& bus_stops = buses[bus_id]->stops;
+            for (size_t position = 0; position < bus_stops.size(); ++position) {
+                position_stops_.push_back(stop_ids[bus_stops[position]]);
+                position_buses_.push_back(bus_id);
+            }
+            bus_offsets_.push_back(static_cast<uint32_t>(position_stops_.size()));
+        }
+
+        stop_offsets_.assign(stops.size() + 1, 0);
+        for (const uint32_t stop_id : position_stops_) {
+            ++stop_offsets_[stop_id + 1];
+        }
+        for (size_t stop_id = 0; stop_id < stops.size(); ++stop_id) {
+            stop_offsets_[stop_id + 1] += stop_offsets_[stop_id];
+        }
+        stop_positions_.resize(position_stops_.size());
+        std::vector<uint32_t> next(stop_offsets_.begin(), stop_offsets_.end() - 1);
+        for (uint32_t position = 0; position < position_stops_.size(); ++position) {
+            stop_positions_[next[position_stops_[position]]++] = position;
+        }
+
+        segment_times_.resize(position_stops_.size());
+        UpdateTimes(buses, bus_velocity, bus_wait_time);
+    }
+
+    void RaptorRouter::UpdateTimes(const std::vector<const domain::Bus*>& buses, double bus_velocity,
+                                   int bus_wait_time) {
+        wait_time_ = static_cast<double>(bus_wait_time);
+        // Время перегона считается так же, как вес ребра RIDE в графе маршрутизатора
+        const double velocity_mps = bus_velocity * 1000.0 / 60.0;
+        for (uint32_t bus_id = 0; bus_id < buses.size(); ++bus_id) {
+            const auto& distances = buses[bus_id]->distances;
+            for (size_t position = 0; position < distances.size(); ++position) {
+                segment_times_[bus_offsets_[bus_id] + position] = distances[position] / velocity_mps;
+            }
+        }
+    }
+
+    std::vector<RaptorJourney> RaptorRouter::BuildJourneys(uint32_t from, uint32_t to,
+                                                           std::optional<size_t> max_transfers) const {
+        const size_t stop_count = stop_offsets_.size() - 1;
+        const size_t bus_count = bus_offsets_.size() - 1;
+        if (from == to) {
+            return {RaptorJourney{0., {}}};
+        }
+
+        // arrivals[k][stop] — лучшее время с не более чем k посадками, best — лучшее за все раунды
+        std::vector<std::vector<double>> arrivals{std::vector<double>(stop_count, INFINITE_TIME)};
+        std::vector<std::vector<Label>> labels{std::vector<Label>(stop_count)};
+        std::vector<double> best(stop_count, INFINITE_TIME);
+        arrivals[0][from] = 0.;
+        best[from] = 0.;
+
+        std::vector<uint32_t> marked_stops{from};
+        std::vector<bool> is_marked(stop_count, false);
+        // Первая позиция маршрута, с которой автобус нужно просмотреть в текущем раунде
+        std::vector<uint32_t> first_positions(bus_count, std::numeric_limits<uint32_t>::max());
+        std::vector<uint32_t> scanned_buses;
+
+        std::vector<RaptorJourney> journeys;
+        const size_t max_rounds = max_transfers ? *max_transfers + 1 : stop_count;
+        for (size_t round = 1; round <= max_rounds && !marked_stops.empty(); ++round) {
+            arrivals.push_back(arrivals.back());
+            labels.emplace_back(stop_count);
+            const std::vector<double>& previous = arrivals[round - 1];
+            std::vector<double>& current = arrivals[round];
+
+            scanned_buses.clear();
+            for (const uint32_t stop : marked_stops) {
+                is_marked[stop] = false;
+                for (uint32_t index = stop_offsets_[stop]; index < stop_offsets_[stop + 1]; ++index) {
+                    const uint32_t position = stop_positions_[index];
+                    const uint32_t bus = position_buses_[position];
+                    if (first_positions[bus] == std::numeric_limits<uint32_t>::max()) {
+                        scanned_buses.push_back(bus);
+                    }
+                    first_positions[bus] = std::min(first_positions[bus], position);
+                }
+            }
+            marked_stops.clear();
+
+            for (const uint32_t bus : scanned_buses) {
+                const uint32_t bus_end = bus_offsets_[bus + 1];
+                double on_board = INFINITE_TIME;
+                uint32_t board_position = 0;
+                for (uint32_t position = first_positions[bus]; position < bus_end; ++position) {
+                    const uint32_t stop = position_stops_[position];
+                    // Время улучшается, только если оно лучше уже известного и в этой остановке,
+                    // и в целевой: иначе такая поездка ничего не даст
+                    if (on_board < std::min(best[stop], best[to])) {
+                        current[stop] = on_board;
+                        best[stop] = on_board;
+                        labels[round][stop] = Label{bus, board_position, position};
+                        if (!is_marked[stop]) {
+                            is_marked[stop] = true;
+                            marked_stops.push_back(stop);
+                        }
+                    }
+                    if (position + 1 == bus_end) {
+                        break;
+                    }
+                    if (previous[stop] + wait_time_ < on_board) {
+                        on_board = previous[stop] + wait_time_;
+                        board_position = position;
+                    }
+                    on_board += segment_times_[position];
+                }
+                first_positions[bus] = std::numeric_limits<uint32_t>::max();
+            }
+
+            if (labels[round][to].bus != NO_BUS) {
+                journeys.push_back(BuildJourney(arrivals, labels, from, to, round));
+            }
+        }
+        return journeys;
+    }
+
+    // Восстановление поездки по меткам: метка остановки ищется в последнем раунде не позже
+    // текущего, где её время улучшалось, а посадка этой поездки — в предыдущем раунде
+    RaptorJourney RaptorRouter::BuildJourney(const std::vector<std::vector<double>>& arrivals,
+                                             const std::vector<std::vector<Label>>& labels,
+                                             uint32_t from, uint32_t to, size_t round) const {
+        RaptorJourney journey{arrivals[round][to], {}};
+        for (uint32_t stop = to; stop != from; --round) {
+            while (labels[round][stop].bus == NO_BUS) {
+                --round;
+            }
+            const Label& label = labels[round][stop];
+            const uint32_t board_stop = position_stops_[label.board_position];
+            const double board_time = arrivals[round - 1][board_stop] + wait_time_;
+            journey.legs.push_back(RaptorLeg{
+                .bus = label.bus,
+                .board_stop = board_stop,
+                .span_count = static_cast<int>(label.alight_position - label.board_position),
+                .ride_time = arrivals[round][stop] - board_time
+            });
+            stop = board_stop;
+        }
+        std::reverse(journey.legs.begin(), journey.legs.end());
+        return journey;
+    }
+} // namespace router
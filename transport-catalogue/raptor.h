@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "transport_catalogue.h"
+
+namespace router {
+    // Поездка на одном автобусе: посадка на остановке board_stop, span_count перегонов
+    struct RaptorLeg {
+        uint32_t bus;
+        uint32_t board_stop;
+        int span_count;
+        double ride_time;
+    };
+
+    struct RaptorJourney {
+        double travel_time;
+        std::vector<RaptorLeg> legs;
+    };
+
+    // Поиск по раундам в духе RAPTOR. В раунде k каждый автобус, на маршруте которого
+    // в прошлом раунде улучшилось время хотя бы одной остановки, просматривается целиком
+    // от первой такой остановки. Время прибытия раунда k — лучшее среди поездок ровно
+    // с k посадками, поэтому улучшения времени в целевой остановке по раундам и дают
+    // Парето-множество по (времени в пути, числу пересадок).
+    // Остановки и автобусы задаются номерами в переданных векторах.
+    class RaptorRouter {
+    public:
+        RaptorRouter(const transport_catalogue::TransportCatalogue& catalogue,
+                     const std::vector<const domain::Stop*>& stops,
+                     const std::vector<const domain::Bus*>& buses,
+                     double bus_velocity, int bus_wait_time);
+
+        // Поездки from -> to, не улучшаемые сразу по обоим критериям, по возрастанию числа
+        // пересадок. max_transfers ограничивает число пересадок. Пустой вектор — пути нет.
+        std::vector<RaptorJourney> BuildJourneys(uint32_t from, uint32_t to,
+                                                 std::optional<size_t> max_transfers = std::nullopt) const;
+        // Пересчитывает время ожидания и времена перегонов на месте, структура маршрутов не меняется
+        void UpdateTimes(const std::vector<const domain::Bus*>& buses, double bus_velocity, int bus_wait_time);
+
+    private:
+        static constexpr uint32_t NO_BUS = UINT32_MAX;
+
+        // Откуда пришли в остановку в раунде, где её время улучшилось
+        struct Label {
+            uint32_t bus = NO_BUS;
+            uint32_t board_position = 0;
+            uint32_t alight_position = 0;
+        };
+
+        RaptorJourney BuildJourney(const std::vector<std::vector<double>>& arrivals,
+                                   const std::vector<std::vector<Label>>& labels,
+                                   uint32_t from, uint32_t to, size_t round) const;
+
+        double wait_time_ = 0.;
+        // Позиции маршрута автобуса bus — [bus_offsets_[bus], bus_offsets_[bus + 1]) в общих массивах
+        std::vector<uint32_t> bus_offsets_;
+        std::vector<uint32_t> position_stops_;
+        // Время перегона от позиции до следующей позиции того же маршрута
+        std::vector<double> segment_times_;
+        std::vector<uint32_t> position_buses_;
+        // Позиции маршрутов, проходящих через остановку stop — [stop_offsets_[stop], stop_offsets_[stop + 1])
+        std::vector<uint32_t> stop_offsets_;
+        std::vector<uint32_t> stop_positions_;
+    };
+} // namespace router
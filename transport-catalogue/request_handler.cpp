@@ -20,30 +20,30 @@ namespace request_handler {
         }
     }
 
-    std::optional<std::set<std::string_view, std::less<>>> RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
+    std::optional<std::span<const BusId>> RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
         StopInfo result = db_.GetStopInfo(stop_name);
         if (result.exists) {
-            std::set<std::string_view, std::less<>> buses;
-            for (const auto& bus : result.buses) {
-                buses.insert(bus);
-            }
-            return buses;
+            return result.buses;
         }
         else {
             return std::nullopt;
         }
     }
 
+    std::string_view RequestHandler::GetBusName(BusId bus) const {
+        return db_.GetBus(bus).bus_name;
+    }
+
     void RequestHandler::RenderMap(std::ostringstream& svg_output) const {
 
         const auto coords = GetStopsCoordinates();
         const renderer::SphereProjector proj(coords.begin(), coords.end(), renderer_.GetSettings().width
                                                                          , renderer_.GetSettings().height
                                                                          , renderer_.GetSettings().padding);                                                                                                                                     
-        renderer_.Render(svg_output, std::move(proj),GetBuses(), GetStops());                      
+        renderer_.Render(svg_output, std::move(proj), db_, GetBuses(), GetStops());                      
     }
 
-    std::set<Stop*, StopComparator> RequestHandler::GetStops() const {
+    std::set<const Stop*, StopComparator> RequestHandler::GetStops() const {
         return db_.GetAllStopsWithBus();
     }
     std::set<const Bus*, BusComparator> RequestHandler::GetBuses() const {
@@ -58,4 +58,29 @@ namespace request_handler {
         return routing_.BuildRoute(from, to);
     }
 
+    std::optional<router::RoutingResult> RequestHandler::BuildRouteDepartingAt(std::string_view from, std::string_view to,
+                                                                               double departure_time) const {
+        return routing_.BuildRouteDepartingAt(from, to, departure_time);
+    }
+
+    std::optional<router::RoutingResult> RequestHandler::BuildRoute(std::string_view from, std::string_view to,
+                                                                    size_t max_transfers) const {
+        return routing_.BuildRoute(from, to, max_transfers);
+    }
+
+    std::vector<router::RoutingResult> RequestHandler::BuildParetoRoutes(std::string_view from, std::string_view to,
+                                                                         std::optional<size_t> max_transfers) const {
+        return routing_.BuildParetoRoutes(from, to, max_transfers);
+    }
+
+    std::vector<std::vector<std::optional<double>>> RequestHandler::ComputeTravelTimes(
+            const std::vector<std::string_view>& from, const std::vector<std::string_view>& to) const {
+        return routing_.ComputeTravelTimes(from, to);
+    }
+
+    std::optional<std::vector<std::pair<std::string_view, double>>> RequestHandler::ComputeIsochrone(
+            std::string_view from, double max_time) const {
+        return routing_.ComputeIsochrone(from, max_time);
+    }
+
 } // namespace request_handler
\ No newline at end of file
@@ -7,18 +7,31 @@
 
 
 namespace request_handler {
+    // Обработчик получает справочник, визуализатор и маршрутизатор только по константным ссылкам,
+    // поэтому ответы на запросы можно считать в нескольких потоках одновременно
     class RequestHandler {
     public:
         RequestHandler(const transport_catalogue::TransportCatalogue& db,
                     const renderer::MapRenderer& renderer,
                     const router::TransportRouter& routing);
         std::optional<domain::BusInfo> GetBusStat(const std::string_view& bus_name) const;
-        std::optional<std::set<std::string_view, std::less<>>> GetBusesByStop(const std::string_view& stop_name) const;
+        // Номера автобусов по возрастанию названий, без копирования индекса справочника
+        std::optional<std::span<const domain::BusId>> GetBusesByStop(const std::string_view& stop_name) const;
+        std::string_view GetBusName(domain::BusId bus) const;
         void RenderMap(std::ostringstream& svg_output) const;
         std::optional<router::RoutingResult> BuildRoute(std::string_view from, std::string_view to) const;
+        std::optional<router::RoutingResult> BuildRoute(std::string_view from, std::string_view to, size_t max_transfers) const;
+        std::optional<router::RoutingResult> BuildRouteDepartingAt(std::string_view from, std::string_view to,
+                                                                   double departure_time) const;
+        std::vector<router::RoutingResult> BuildParetoRoutes(std::string_view from, std::string_view to,
+                                                             std::optional<size_t> max_transfers) const;
+        std::vector<std::vector<std::optional<double>>> ComputeTravelTimes(const std::vector<std::string_view>& from,
+                                                                           const std::vector<std::string_view>& to) const;
+        std::optional<std::vector<std::pair<std::string_view, double>>> ComputeIsochrone(std::string_view from,
+                                                                                         double max_time) const;
         
     private:
-        std::set<domain::Stop*, domain::StopComparator> GetStops() const;
+        std::set<const domain::Stop*, domain::StopComparator> GetStops() const;
         std::set<const domain::Bus*, domain::BusComparator> GetBuses() const;
         std::vector<geo::Coordinates> GetStopsCoordinates() const;
         const transport_catalogue::TransportCatalogue& db_;
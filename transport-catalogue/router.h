@@ -1,12 +1,19 @@
 #pragma once
 
+#include "contraction_hierarchy.h"
+#include "floyd_warshall.h"
 #include "graph.h"
+#include "parallel.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -14,13 +21,28 @@
 
 namespace graph {
 
+// Способ поиска маршрутов
+enum class RouterMode {
+    ALL_PAIRS,  // предрасчёт кратчайших путей между всеми парами вершин, O(V^3) времени и O(V^2) памяти
+    ALL_PAIRS_DIJKSTRA,   // та же таблица, заполняемая поиском Дейкстры от каждой вершины в несколько потоков
+    DIJKSTRA,   // поиск по запросу алгоритмом Дейкстры с ранней остановкой, хранится только граф
+    BIDIRECTIONAL_ASTAR,  // встречный поиск A* от обеих вершин с эвристикой — нижней оценкой расстояния
+    CONTRACTION_HIERARCHY // предрасчёт иерархии сжатия, запрос — встречный поиск по рёбрам «вверх»
+};
+
 template <typename Weight>
 class Router {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
-    explicit Router(const Graph& graph);
+    // Нижняя оценка веса пути между двумя вершинами. Должна быть согласованной:
+    // heuristic(u, t) <= weight(u, v) + heuristic(v, t) для любого ребра u -> v
+    using Heuristic = std::function<Weight(VertexId from, VertexId to)>;
+
+    // thread_count — число потоков предрасчёта (0 — по числу ядер)
+    explicit Router(const Graph& graph, RouterMode mode = RouterMode::DIJKSTRA, Heuristic heuristic = {},
+                    size_t thread_count = 1);
 
     struct RouteInfo {
         Weight weight;
@@ -29,89 +51,585 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Веса кратчайших путей из from во все вершины, не тяжелее limit; std::nullopt — пути нет
+    // или он тяжелее limit. В режимах ALL_PAIRS* читается строка таблицы, в остальных
+    // выполняется один поиск Дейкстры от from по всему графу.
+    std::vector<std::optional<Weight>> BuildWeightsFrom(VertexId from, std::optional<Weight> limit = std::nullopt) const;
+
+    // Поиск по времени отправления: время прохождения ребра travel_time(edge_id, entry_time) зависит
+    // от момента входа в него, бесконечность — ребро недоступно. Функция должна сохранять порядок
+    // (FIFO): войдя в ребро позже, нельзя выйти из него раньше, тогда поиск Дейкстры по моментам
+    // прибытия остаётся точным. Вес результата — время в пути от departure до прибытия в to.
+    // Работает в любом режиме: предрасчёт строится по постоянным весам и здесь не используется.
+    template <typename TravelTime>
+    std::optional<RouteInfo> BuildRouteDepartingAt(VertexId from, VertexId to, Weight departure,
+                                                   TravelTime travel_time) const;
+
+    // Прежний вес ребра, изменённого в графе через SetEdgeWeight
+    struct EdgeWeightChange {
+        EdgeId edge_id;
+        Weight old_weight;
+    };
+
+    // Вызывается после изменения весов рёбер графа и чинит только затронутые данные:
+    // в режимах ALL_PAIRS* пересчитываются строки таблицы, в деревьях кратчайших путей которых
+    // есть подорожавшее ребро или через подешевевшее ребро путь стал короче; иерархия сжатия
+    // строится заново; поиску по запросу достаточно самого графа.
+    void UpdateEdgeWeights(const std::vector<EdgeWeightChange>& changes);
+    // Эвристика режима BIDIRECTIONAL_ASTAR должна оставаться нижней оценкой и после изменения весов
+    void SetHeuristic(Heuristic heuristic);
+
 private:
     struct RouteInternalData {
         Weight weight;
         std::optional<EdgeId> prev_edge;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
-    void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
-                if (edge.weight < ZERO_WEIGHT) {
-                    throw std::domain_error("Edges' weights should be non-negative");
-                }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
-                }
+    void CheckEdgesWeights(const Graph& graph) const {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
-        }
-    }
+    void BuildAllPairsFloydWarshall(const Graph& graph, size_t thread_count);
+    void BuildAllPairsDijkstra(const Graph& graph, size_t thread_count);
+    template <typename Heap>
+    void ComputeAllPairsRow(VertexId from, Heap& heap);
+    bool IsAllPairsRowTree(VertexId from, std::vector<VertexId>& marks) const;
+    bool IsAllPairsRowAffected(VertexId from, const std::vector<EdgeWeightChange>& changes) const;
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
-                }
-            }
-        }
-    }
+    std::optional<RouteInfo> BuildRouteAllPairs(VertexId from, VertexId to) const;
+    std::optional<RouteInfo> BuildRouteDijkstra(VertexId from, VertexId to) const;
+    std::vector<std::optional<RouteInternalData>> RunDijkstra(VertexId from, std::optional<VertexId> target,
+                                                             std::optional<Weight> limit) const;
+    std::optional<RouteInfo> BuildRouteBidirectionalAStar(VertexId from, VertexId to) const;
 
     static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    RouterMode mode_;
+    Heuristic heuristic_;
+    size_t thread_count_;
+    // Таблица всех пар в режимах ALL_PAIRS*: элемент from * V + to хранит вес кратчайшего пути
+    // (INFINITE_WEIGHT — пути нет) и последнее ребро этого пути (NO_EDGE — путь пуст или его нет)
+    std::vector<Weight> all_pairs_weights_;
+    std::vector<uint32_t> all_pairs_prev_edges_;
+    // Граф с обращёнными рёбрами и теми же EdgeId — для обратного поиска в режиме BIDIRECTIONAL_ASTAR
+    Graph reversed_graph_;
+    std::unique_ptr<ContractionHierarchy<Weight>> hierarchy_;
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, RouterMode mode, Heuristic heuristic, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , mode_(mode)
+    , heuristic_(std::move(heuristic))
+    , thread_count_(thread_count)
 {
-    InitializeRoutesInternalData(graph);
+    if (mode_ == RouterMode::DIJKSTRA) {
+        CheckEdgesWeights(graph);
+        return;
+    }
+    if (mode_ == RouterMode::BIDIRECTIONAL_ASTAR) {
+        CheckEdgesWeights(graph);
+        if (!heuristic_) {
+            // Без эвристики поиск вырождается в двунаправленный алгоритм Дейкстры
+            heuristic_ = [](VertexId, VertexId) { return ZERO_WEIGHT; };
+        }
+        reversed_graph_ = Graph(graph.GetVertexCount());
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            reversed_graph_.AddEdge({edge.to, edge.from, edge.weight});
+        }
+        reversed_graph_.Finalize();
+        return;
+    }
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHY) {
+        hierarchy_ = std::make_unique<ContractionHierarchy<Weight>>(graph, thread_count);
+        return;
+    }
+
+    CheckEdgesWeights(graph);
+    const size_t vertex_count = graph.GetVertexCount();
+    all_pairs_weights_.assign(vertex_count * vertex_count, INFINITE_WEIGHT);
+    all_pairs_prev_edges_.assign(vertex_count * vertex_count, NO_EDGE);
+    if (mode_ == RouterMode::ALL_PAIRS_DIJKSTRA) {
+        BuildAllPairsDijkstra(graph, thread_count);
+    } else {
+        BuildAllPairsFloydWarshall(graph, thread_count);
+    }
+}
+
+template <typename Weight>
+void Router<Weight>::BuildAllPairsFloydWarshall(const Graph& graph, size_t thread_count) {
+    const size_t vertex_count = graph.GetVertexCount();
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        all_pairs_weights_[vertex * vertex_count + vertex] = ZERO_WEIGHT;
+        const auto arcs = graph.GetIncidentArcs(vertex);
+        for (size_t index = 0; index < arcs.targets.size(); ++index) {
+            const size_t cell = vertex * vertex_count + arcs.targets[index];
+            if (arcs.weights[index] < all_pairs_weights_[cell]) {
+                all_pairs_weights_[cell] = arcs.weights[index];
+                all_pairs_prev_edges_[cell] = arcs.edge_ids[index];
+            }
+        }
+    }
+
+    BlockedFloydWarshall<Weight>(all_pairs_weights_.data(), all_pairs_prev_edges_.data(), vertex_count)
+        .Run(thread_count);
+
+    // Веса блочный алгоритм считает точно, но при рёбрах нулевого веса (например, нулевое время
+    // ожидания) порядок релаксаций может оставить в строке цикл последних рёбер. Такие строки
+    // пересчитываются поиском Дейкстры, его последние рёбра всегда образуют дерево.
+    using QueueItem = std::pair<Weight, VertexId>;
+    const size_t worker_count = parallel::ResolveThreadCount(thread_count);
+    std::vector<std::vector<QueueItem>> heaps(worker_count);
+    std::vector<std::vector<VertexId>> marks(worker_count);
+    parallel::ForEachIndex(vertex_count, thread_count, [&](size_t from, size_t worker) {
+        if (IsAllPairsRowTree(from, marks[worker])) {
+            return;
+        }
+        std::fill_n(all_pairs_weights_.begin() + from * vertex_count, vertex_count, INFINITE_WEIGHT);
+        std::fill_n(all_pairs_prev_edges_.begin() + from * vertex_count, vertex_count, NO_EDGE);
+        ComputeAllPairsRow(from, heaps[worker]);
+    });
+}
+
+// Последние рёбра строки from образуют дерево с корнем from, если цепочка последних рёбер от любой
+// достижимой вершины приходит в from. marks[v] — вершина, с которой начат обход, прошедший через v:
+// встреча своей метки означает цикл, чужой — что дальше цепочка уже проверена. O(V) на строку.
+template <typename Weight>
+bool Router<Weight>::IsAllPairsRowTree(VertexId from, std::vector<VertexId>& marks) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const Weight* weights = all_pairs_weights_.data() + from * vertex_count;
+    const uint32_t* prev_edges = all_pairs_prev_edges_.data() + from * vertex_count;
+    constexpr VertexId UNMARKED = std::numeric_limits<VertexId>::max();
+    marks.assign(vertex_count, UNMARKED);
+    marks[from] = from;
+    for (VertexId start = 0; start < vertex_count; ++start) {
+        if (weights[start] == INFINITE_WEIGHT) {
+            continue;
+        }
+        VertexId vertex = start;
+        while (marks[vertex] == UNMARKED) {
+            marks[vertex] = start;
+            if (prev_edges[vertex] == NO_EDGE) {
+                return false;
+            }
+            vertex = graph_.GetEdge(prev_edges[vertex]).from;
+        }
+        if (vertex != from && marks[vertex] == start) {
+            return false;
+        }
+    }
+    return true;
+}
 
+// Поиски от разных вершин независимы и пишут каждый в свою строку таблицы, поэтому
+// потоки не синхронизируются. Строка таблицы сама служит массивом расстояний поиска.
+template <typename Weight>
+void Router<Weight>::BuildAllPairsDijkstra(const Graph& graph, size_t thread_count) {
     const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::vector<std::vector<QueueItem>> heaps(parallel::ResolveThreadCount(thread_count));
+
+    parallel::ForEachIndex(vertex_count, thread_count, [&](size_t from, size_t worker) {
+        ComputeAllPairsRow(from, heaps[worker]);
+    });
+}
+
+// Строка таблицы должна быть заполнена INFINITE_WEIGHT и NO_EDGE
+template <typename Weight>
+template <typename Heap>
+void Router<Weight>::ComputeAllPairsRow(VertexId from, Heap& heap) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    Weight* weights = all_pairs_weights_.data() + from * vertex_count;
+    uint32_t* prev_edges = all_pairs_prev_edges_.data() + from * vertex_count;
+    const auto compare = std::greater<typename Heap::value_type>{};
+
+    heap.clear();
+    weights[from] = ZERO_WEIGHT;
+    heap.emplace_back(ZERO_WEIGHT, from);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const auto [weight, vertex] = heap.back();
+        heap.pop_back();
+        if (weights[vertex] < weight) {
+            continue;
+        }
+        const auto arcs = graph_.GetIncidentArcs(vertex);
+        for (size_t index = 0; index < arcs.targets.size(); ++index) {
+            const VertexId next = arcs.targets[index];
+            const Weight candidate_weight = weight + arcs.weights[index];
+            if (candidate_weight < weights[next]) {
+                weights[next] = candidate_weight;
+                prev_edges[next] = arcs.edge_ids[index];
+                heap.emplace_back(candidate_weight, next);
+                std::push_heap(heap.begin(), heap.end(), compare);
+            }
+        }
+    }
+}
+
+// Строка from не меняется, если ни одно подорожавшее ребро не входит в её дерево кратчайших
+// путей и ни одно подешевевшее не даёт более короткого пути до своего конца
+template <typename Weight>
+bool Router<Weight>::IsAllPairsRowAffected(VertexId from, const std::vector<EdgeWeightChange>& changes) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const Weight* weights = all_pairs_weights_.data() + from * vertex_count;
+    const uint32_t* prev_edges = all_pairs_prev_edges_.data() + from * vertex_count;
+    for (const auto& change : changes) {
+        const auto& edge = graph_.GetEdge(change.edge_id);
+        if (prev_edges[edge.to] == change.edge_id) {
+            return true;
+        }
+        if (edge.weight < change.old_weight && weights[edge.from] + edge.weight < weights[edge.to]) {
+            return true;
+        }
     }
+    return false;
+}
+
+template <typename Weight>
+void Router<Weight>::UpdateEdgeWeights(const std::vector<EdgeWeightChange>& changes) {
+    for (const auto& change : changes) {
+        if (graph_.GetEdge(change.edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+
+    switch (mode_) {
+        case RouterMode::DIJKSTRA:
+            break;
+        case RouterMode::BIDIRECTIONAL_ASTAR:
+            for (const auto& change : changes) {
+                reversed_graph_.SetEdgeWeight(change.edge_id, graph_.GetEdge(change.edge_id).weight);
+            }
+            break;
+        case RouterMode::CONTRACTION_HIERARCHY:
+            // Набор сокращений зависит от весов, поэтому иерархия не чинится, а строится заново
+            hierarchy_ = std::make_unique<ContractionHierarchy<Weight>>(graph_, thread_count_);
+            break;
+        default: {
+            const size_t vertex_count = graph_.GetVertexCount();
+            using QueueItem = std::pair<Weight, VertexId>;
+            std::vector<std::vector<QueueItem>> heaps(parallel::ResolveThreadCount(thread_count_));
+            parallel::ForEachIndex(vertex_count, thread_count_, [&](size_t from, size_t worker) {
+                if (!IsAllPairsRowAffected(from, changes)) {
+                    return;
+                }
+                std::fill_n(all_pairs_weights_.begin() + from * vertex_count, vertex_count, INFINITE_WEIGHT);
+                std::fill_n(all_pairs_prev_edges_.begin() + from * vertex_count, vertex_count, NO_EDGE);
+                ComputeAllPairsRow(from, heaps[worker]);
+            });
+            break;
+        }
+    }
+}
+
+template <typename Weight>
+void Router<Weight>::SetHeuristic(Heuristic heuristic) {
+    heuristic_ = heuristic ? std::move(heuristic) : [](VertexId, VertexId) { return ZERO_WEIGHT; };
 }
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    switch (mode_) {
+        case RouterMode::DIJKSTRA:
+            return BuildRouteDijkstra(from, to);
+        case RouterMode::BIDIRECTIONAL_ASTAR:
+            return BuildRouteBidirectionalAStar(from, to);
+        case RouterMode::CONTRACTION_HIERARCHY:
+            if (auto route = hierarchy_->BuildRoute(from, to)) {
+                return RouteInfo{route->weight, std::move(route->edges)};
+            }
+            return std::nullopt;
+        default:
+            return BuildRouteAllPairs(from, to);
+    }
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>> Router<Weight>::BuildWeightsFrom(VertexId from, std::optional<Weight> limit) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<std::optional<Weight>> weights(vertex_count);
+    auto fits = [&limit](Weight weight) {
+        return !limit || !(*limit < weight);
+    };
+
+    if (mode_ == RouterMode::ALL_PAIRS || mode_ == RouterMode::ALL_PAIRS_DIJKSTRA) {
+        if (from >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const Weight* row = all_pairs_weights_.data() + from * vertex_count;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (row[vertex] != INFINITE_WEIGHT && fits(row[vertex])) {
+                weights[vertex] = row[vertex];
+            }
+        }
+        return weights;
+    }
+
+    const auto routes = RunDijkstra(from, std::nullopt, limit);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        // Вес вершины за пределом limit мог не успеть стать окончательным, но он всё равно тяжелее limit
+        if (routes[vertex] && fits(routes[vertex]->weight)) {
+            weights[vertex] = routes[vertex]->weight;
+        }
+    }
+    return weights;
+}
+
+template <typename Weight>
+template <typename TravelTime>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRouteDepartingAt(
+        VertexId from, VertexId to, Weight departure, TravelTime travel_time) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    // routes[v].weight — момент прибытия в v
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    std::vector<std::optional<RouteInternalData>> routes(vertex_count);
+    std::vector<bool> settled(vertex_count, false);
+
+    routes[from] = RouteInternalData{departure, std::nullopt};
+    queue.emplace(departure, from);
+    while (!queue.empty()) {
+        const auto [arrival, vertex] = queue.top();
+        queue.pop();
+        if (settled[vertex]) {
+            continue;
+        }
+        settled[vertex] = true;
+        if (vertex == to) {
+            break;
+        }
+        const auto arcs = graph_.GetIncidentArcs(vertex);
+        for (size_t index = 0; index < arcs.targets.size(); ++index) {
+            const Weight edge_time = travel_time(EdgeId{arcs.edge_ids[index]}, arrival);
+            if (edge_time == INFINITE_WEIGHT) {
+                continue;
+            }
+            const VertexId next = arcs.targets[index];
+            const Weight candidate_arrival = arrival + edge_time;
+            auto& route = routes[next];
+            if (!route || candidate_arrival < route->weight) {
+                route = RouteInternalData{candidate_arrival, arcs.edge_ids[index]};
+                queue.emplace(candidate_arrival, next);
+            }
+        }
+    }
+
+    if (!routes[to]) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = routes[to]->prev_edge;
+         edge_id;
+         edge_id = routes[graph_.GetEdge(*edge_id).from]->prev_edge)
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{routes[to]->weight - departure, std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRouteAllPairs(VertexId from,
+                                                                                     VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const Weight* weights = all_pairs_weights_.data() + from * vertex_count;
+    const uint32_t* prev_edges = all_pairs_prev_edges_.data() + from * vertex_count;
+    if (weights[to] == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (uint32_t edge_id = prev_edges[to]; edge_id != NO_EDGE; edge_id = prev_edges[graph_.GetEdge(edge_id).from]) {
+        // Кратчайший путь не длиннее V - 1 рёбер, более длинная цепочка — повреждённая таблица
+        if (edges.size() == vertex_count) {
+            throw std::logic_error("All-pairs route table has a cycle");
+        }
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weights[to], std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRouteDijkstra(VertexId from,
+                                                                                     VertexId to) const {
+    if (to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const auto routes = RunDijkstra(from, to, std::nullopt);
+    if (!routes[to]) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = routes[to]->prev_edge;
+         edge_id;
+         edge_id = routes[graph_.GetEdge(*edge_id).from]->prev_edge)
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{routes[to]->weight, std::move(edges)};
+}
+
+// Поиск останавливается, когда извлечена цель target или вес очередной вершины превысил limit.
+// Вершины, до которых поиск не дошёл, могут остаться с неокончательными весами.
+template <typename Weight>
+std::vector<std::optional<typename Router<Weight>::RouteInternalData>> Router<Weight>::RunDijkstra(
+        VertexId from, std::optional<VertexId> target, std::optional<Weight> limit) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    // Куча с ленивым удалением: устаревшие записи пропускаются при извлечении
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    std::vector<std::optional<RouteInternalData>> routes(vertex_count);
+    std::vector<bool> settled(vertex_count, false);
+
+    routes[from] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+    queue.emplace(ZERO_WEIGHT, from);
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (settled[vertex]) {
+            continue;
+        }
+        if (limit && *limit < weight) {
+            break;
+        }
+        settled[vertex] = true;
+        // Кратчайший путь до цели найден, остальной граф можно не просматривать
+        if (vertex == target) {
+            break;
+        }
+        const auto arcs = graph_.GetIncidentArcs(vertex);
+        for (size_t index = 0; index < arcs.targets.size(); ++index) {
+            const VertexId next = arcs.targets[index];
+            const Weight candidate_weight = weight + arcs.weights[index];
+            auto& route = routes[next];
+            if (!route || candidate_weight < route->weight) {
+                route = RouteInternalData{candidate_weight, arcs.edge_ids[index]};
+                queue.emplace(candidate_weight, next);
+            }
+        }
+    }
+    return routes;
+}
+
+// Встречный A* со средними потенциалами: p(v) = (h(v, to) - h(from, v)) / 2 для прямого поиска
+// и -p(v) для обратного. Приведённые веса рёбер неотрицательны в обоих направлениях, поэтому
+// поиск можно остановить, как только сумма минимальных ключей двух очередей достигнет
+// длины лучшего найденного пути.
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRouteBidirectionalAStar(VertexId from,
+                                                                                               VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    std::vector<std::optional<Weight>> potentials(vertex_count);
+    auto potential = [&](VertexId vertex) {
+        auto& value = potentials[vertex];
+        if (!value) {
+            value = (heuristic_(vertex, to) - heuristic_(from, vertex)) / 2;
+        }
+        return *value;
+    };
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+    // Индекс 0 — прямой поиск от from, 1 — обратный от to
+    std::vector<std::optional<RouteInternalData>> routes[2] = {
+        std::vector<std::optional<RouteInternalData>>(vertex_count),
+        std::vector<std::optional<RouteInternalData>>(vertex_count)};
+    Queue queues[2];
+
+    routes[0][from] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+    routes[1][to] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+    queues[0].emplace(potential(from), from);
+    queues[1].emplace(-potential(to), to);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+
+    while (!queues[0].empty() && !queues[1].empty()) {
+        if (best_weight && !(queues[0].top().first + queues[1].top().first < *best_weight)) {
+            break;
+        }
+        const int side = queues[0].size() <= queues[1].size() ? 0 : 1;
+        const auto [key, vertex] = queues[side].top();
+        queues[side].pop();
+
+        const Weight sign = side == 0 ? Weight{1} : Weight{-1};
+        const Weight weight = routes[side][vertex]->weight;
+        // Устаревшая запись: вершина уже извлечена с меньшим ключом
+        if (weight + sign * potential(vertex) < key) {
+            continue;
+        }
+
+        const auto arcs = side == 0 ? graph_.GetIncidentArcs(vertex) : reversed_graph_.GetIncidentArcs(vertex);
+        for (size_t index = 0; index < arcs.targets.size(); ++index) {
+            const VertexId next = arcs.targets[index];
+            const Weight candidate_weight = weight + arcs.weights[index];
+            auto& route = routes[side][next];
+            if (route && !(candidate_weight < route->weight)) {
+                continue;
+            }
+            route = RouteInternalData{candidate_weight, arcs.edge_ids[index]};
+            queues[side].emplace(candidate_weight + sign * potential(next), next);
+
+            if (const auto& opposite = routes[1 - side][next]) {
+                const Weight total_weight = candidate_weight + opposite->weight;
+                if (!best_weight || total_weight < *best_weight) {
+                    best_weight = total_weight;
+                    meeting_vertex = next;
+                }
+            }
+        }
+    }
+
+    if (!best_weight) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
+    for (std::optional<EdgeId> edge_id = routes[0][meeting_vertex]->prev_edge;
          edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+         edge_id = routes[0][graph_.GetEdge(*edge_id).from]->prev_edge)
     {
         edges.push_back(*edge_id);
     }
     std::reverse(edges.begin(), edges.end());
+    for (std::optional<EdgeId> edge_id = routes[1][meeting_vertex]->prev_edge;
+         edge_id;
+         edge_id = routes[1][graph_.GetEdge(*edge_id).to]->prev_edge)
+    {
+        edges.push_back(*edge_id);
+    }
 
-    return RouteInfo{weight, std::move(edges)};
+    return RouteInfo{*best_weight, std::move(edges)};
 }
 
 }  // namespace graph
\ No newline at end of file
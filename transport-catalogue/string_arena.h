@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+    // Хранилище строк: строки копируются подряд в большие блоки вместо отдельных std::string.
+    // Блоки не перемещаются, поэтому выданные string_view действительны всё время жизни арены,
+    // в том числе после её перемещения.
+    class StringArena {
+    public:
+        std::string_view Store(std::string_view text) {
+            if (text.empty()) {
+                return {};
+            }
+            // Длинная строка получает собственный блок, текущий блок продолжает заполняться
+            if (text.size() > BLOCK_SIZE / 4) {
+                auto block = std::make_unique<char[]>(text.size());
+                std::memcpy(block.get(), text.data(), text.size());
+                const std::string_view stored(block.get(), text.size());
+                blocks_.insert(blocks_.empty() ? blocks_.end() : std::prev(blocks_.end()), std::move(block));
+                return stored;
+            }
+            if (block_used_ + text.size() > BLOCK_SIZE) {
+                blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+                block_used_ = 0;
+            }
+            char* data = blocks_.back().get() + block_used_;
+            std::memcpy(data, text.data(), text.size());
+            block_used_ += text.size();
+            return {data, text.size()};
+        }
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        // Занято байт в последнем блоке
+        size_t block_used_ = BLOCK_SIZE;
+    };
+} // namespace transport_catalogue
@@ -0,0 +1,199 @@
+// Проверки разбора JSON: чтение из потока и из буфера в памяти, скалярное ядро и ядро AVX2
+// первого этапа должны давать одинаковые документы. Сборка и запуск из каталога transport-catalogue:
+//   g++ -std=c++20 -O2 -o json_test tests/json_test.cpp json.cpp
+//   ./json_test [каталог с примерами, по умолчанию tests/data]
+// Код возврата 0 — все проверки прошли, иначе в cerr выводятся непрошедшие.
+#include "../json.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    using namespace std::literals;
+
+    int failures = 0;
+
+    void Check(bool condition, const std::string& message) {
+        if (!condition) {
+            ++failures;
+            std::cerr << "FAILED: " << message << std::endl;
+        }
+    }
+
+    std::string PrintDocument(const json::Document& document) {
+        std::ostringstream output;
+        json::Print(document, output, json::PrintFormat::COMPACT);
+        return output.str();
+    }
+
+    // Записывает события потокового разбора в строку
+    class RecordingHandler : public json::SaxHandler {
+    public:
+        void StartDict() override { events_ += "{"; }
+        void EndDict() override { events_ += "}"; }
+        void StartArray() override { events_ += "["; }
+        void EndArray() override { events_ += "]"; }
+        void Key(std::string_view key) override { (events_ += "K:") += key; events_ += '\n'; }
+        void Value(std::nullptr_t) override { events_ += "null\n"; }
+        void Value(bool value) override { events_ += value ? "true\n" : "false\n"; }
+        void Value(int value) override { events_ += "I:" + std::to_string(value) + '\n'; }
+        void Value(double value) override { events_ += "D:" + std::to_string(value) + '\n'; }
+        void Value(std::string_view value) override { (events_ += "S:") += value; events_ += '\n'; }
+
+        const std::string& GetEvents() const { return events_; }
+
+    private:
+        std::string events_;
+    };
+
+    std::string ParseEvents(std::string_view input) {
+        RecordingHandler handler;
+        json::Parse(input, handler);
+        return handler.GetEvents();
+    }
+
+    std::string ParseEventsFromStream(std::string_view input) {
+        std::istringstream stream{std::string(input)};
+        RecordingHandler handler;
+        json::Parse(stream, handler);
+        return handler.GetEvents();
+    }
+
+    // Текст документа при текущем ядре; документы из потока и из буфера, в куче и в арене,
+    // а также события потокового разбора обоих видов ввода должны совпадать
+    std::string LoadInAllModes(const std::string& name, std::string_view input) {
+        const json::Document from_buffer = json::Load(input);
+        const std::string text = PrintDocument(from_buffer);
+        for (const auto allocation : {json::Allocation::HEAP, json::Allocation::ARENA}) {
+            std::istringstream stream{std::string(input)};
+            const json::Document from_stream = json::Load(stream, allocation);
+            const json::Document from_buffer_in_allocation = json::Load(input, allocation);
+            Check(from_stream == from_buffer, name + ": stream and buffer documents differ");
+            Check(from_buffer_in_allocation == from_buffer, name + ": heap and arena documents differ");
+            Check(PrintDocument(from_stream) == text, name + ": stream and buffer output differ");
+        }
+        Check(ParseEventsFromStream(input) == ParseEvents(input), name + ": stream and buffer events differ");
+        return text;
+    }
+
+    std::string ReadFile(const std::string& path) {
+        std::ifstream input(path, std::ios::binary);
+        Check(input.is_open(), "cannot open " + path);
+        return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+
+    // Серии обратных слешей разной длины у границ 64-байтных блоков первого этапа
+    std::string MakeEscapesInput() {
+        std::string input = "[";
+        for (size_t padding = 0; padding < 70; ++padding) {
+            for (size_t backslashes = 1; backslashes <= 5; ++backslashes) {
+                input += "\"" + std::string(padding, 'a');
+                for (size_t index = 0; index < backslashes; ++index) {
+                    input += "\\\\";
+                }
+                input += "\\\"x\\n\\t\", ";
+            }
+        }
+        input += "\"Юникод\\r\"]";
+        return input;
+    }
+
+    // Документ в несколько порций чтения из потока: числа, строки и литералы попадают на границы порций
+    std::string MakeLargeInput() {
+        std::string input = "{\"items\": [\r\n";
+        for (int item = 0; item < 20000; ++item) {
+            input += "\t{\"id\": " + std::to_string(item * 7919 - 50000)
+                + ", \"ratio\": " + std::to_string(item) + "." + std::to_string(item % 97) + "e-" + std::to_string(item % 5)
+                + ", \"name\": \"Stop " + std::to_string(item) + " \\\"q\\\"\""
+                + ", \"flags\": [true, false, null, {}, []]},\r\n";
+        }
+        input += "\t{\"id\": -0, \"ratio\": 1.5E+3}\r\n]}";
+        return input;
+    }
+
+    const std::vector<std::pair<std::string, std::string>> SMALL_INPUTS = {
+        {"scalar", "  -12.5e2  "},
+        {"integer", "2147483647"},
+        {"string", "\"value\""},
+        {"literals", "[true,false,null]"},
+        {"empty containers", "{\"a\":[],\"b\":{},\"c\":[[]],\"d\":[{}]}"},
+        {"nested", "{\"z\": {\"y\": [1, 2.0, -3, {\"x\": \"w\"}]}, \"a\": 0}"},
+        {"whitespace", "\r\n\t[ 1 ,\t2 ,\r\n 3 ]\n\n"},
+    };
+
+    const std::vector<std::string> SAMPLE_FILES = {
+        "readme_route_input.json",
+        "readme_map_input.json",
+        "readme_map_output.json",
+    };
+
+    // Текст каждого документа при текущем ядре
+    std::map<std::string, std::string> LoadAllInputs(const std::string& data_directory) {
+        std::map<std::string, std::string> texts;
+        for (const auto& [name, input] : SMALL_INPUTS) {
+            texts[name] = LoadInAllModes(name, input);
+        }
+        for (const auto& file : SAMPLE_FILES) {
+            texts[file] = LoadInAllModes(file, ReadFile(data_directory + "/" + file));
+        }
+        texts["escapes"] = LoadInAllModes("escapes", MakeEscapesInput());
+        texts["large"] = LoadInAllModes("large", MakeLargeInput());
+        return texts;
+    }
+
+    void TestKernelsBuildSameDocuments(const std::string& data_directory) {
+        Check(json::detail::SetScanKernel(json::detail::ScanKernel::SCALAR), "scalar kernel is unavailable");
+        const auto scalar_texts = LoadAllInputs(data_directory);
+        if (!json::detail::SetScanKernel(json::detail::ScanKernel::AVX2)) {
+            std::cout << "AVX2 kernel is unavailable, only the scalar kernel is checked" << std::endl;
+            return;
+        }
+        const auto avx2_texts = LoadAllInputs(data_directory);
+        for (const auto& [name, text] : scalar_texts) {
+            Check(avx2_texts.at(name) == text, name + ": scalar and AVX2 kernels build different documents");
+        }
+    }
+
+    template <typename Function>
+    bool ThrowsParsingError(Function function) {
+        try {
+            function();
+        } catch (const json::ParsingError&) {
+            return true;
+        }
+        return false;
+    }
+
+    // После корневого значения допустимы только пробельные символы
+    void TestTrailingData() {
+        for (const std::string_view input : {"[1,2] x"sv, "{\"a\":1}}"sv, "1 2"sv, "\"a\" \"b\""sv, "[] []"sv, "null,"sv}) {
+            const std::string name = "trailing data in '" + std::string(input) + "'";
+            Check(ThrowsParsingError([input] { json::Load(input); }), name + " is accepted from buffer");
+            Check(ThrowsParsingError([input] {
+                std::istringstream stream{std::string(input)};
+                json::Load(stream, json::Allocation::ARENA);
+            }), name + " is accepted from stream");
+            Check(ThrowsParsingError([input] { ParseEvents(input); }), name + " is accepted by buffer events");
+            Check(ThrowsParsingError([input] { ParseEventsFromStream(input); }), name + " is accepted by stream events");
+        }
+        Check(json::Load("[1] \r\n\t "sv).GetRoot() == json::Node(json::Array{1}), "trailing whitespace is rejected");
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const std::string data_directory = argc > 1 ? argv[1] : "tests/data";
+    TestKernelsBuildSameDocuments(data_directory);
+    TestTrailingData();
+    if (failures != 0) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All JSON tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,286 @@
+// Проверки маршрутизатора на случайных сетях. Сборка и запуск из каталога transport-catalogue:
+//   g++ -std=c++20 -O2 -pthread -o router_test tests/router_test.cpp
+//       transport_router.cpp transport_catalogue.cpp raptor.cpp floyd_warshall.cpp geo.cpp
+//   ./router_test
+// Код возврата 0 — все проверки прошли, иначе в cerr выводятся непрошедшие.
+#include "../transport_router.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+    using transport_catalogue::TransportCatalogue;
+
+    int failures = 0;
+
+    void Check(bool condition, const std::string& message) {
+        if (!condition) {
+            ++failures;
+            std::cerr << "FAILED: " << message << std::endl;
+        }
+    }
+
+    bool IsClose(double lhs, double rhs) {
+        return std::abs(lhs - rhs) < 1e-6;
+    }
+
+    std::string GetStopName(size_t stop) {
+        return "Stop " + std::to_string(stop);
+    }
+
+    // Случайная сеть: маршруты кольцевые и некольцевые, часть остановок без автобусов,
+    // расстояния перегонов заданы в одну сторону или в обе
+    void FillNetwork(TransportCatalogue& catalogue, unsigned seed, size_t stop_count, size_t bus_count) {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<double> latitude(55.5, 55.8);
+        std::uniform_real_distribution<double> longitude(37.4, 37.8);
+        std::uniform_int_distribution<size_t> stop_index(0, stop_count - 1);
+        std::uniform_int_distribution<size_t> route_size(2, 12);
+        std::uniform_int_distribution<int> distance(100, 5000);
+
+        for (size_t stop = 0; stop < stop_count; ++stop) {
+            catalogue.AddStop(GetStopName(stop), geo::Coordinates{latitude(random), longitude(random)});
+        }
+        for (size_t bus = 0; bus < bus_count; ++bus) {
+            std::vector<domain::StopId> stops(route_size(random));
+            for (auto& stop : stops) {
+                stop = static_cast<domain::StopId>(stop_index(random));
+            }
+            const bool is_roundtrip = random() % 2 == 0;
+            // Некольцевой маршрут хранится целиком: туда и обратно
+            if (is_roundtrip) {
+                stops.push_back(stops.front());
+            } else {
+                stops.insert(stops.end(), stops.rbegin() + 1, stops.rend());
+            }
+            for (size_t position = 0; position + 1 < stops.size(); ++position) {
+                catalogue.SetStopDistance(stops[position], stops[position + 1], distance(random));
+                if (random() % 2 == 0) {
+                    catalogue.SetStopDistance(stops[position + 1], stops[position], distance(random));
+                }
+            }
+            catalogue.AddBus("Bus " + std::to_string(bus), is_roundtrip, stops);
+        }
+        catalogue.Finalize();
+    }
+
+    // Части маршрута чередуются: ожидание на остановке, где пассажир сейчас, затем поездка на span_count
+    // перегонов автобуса от этой остановки со временем по расстояниям справочника. Маршрут ведёт из from в to,
+    // а его время — сумма времён частей. Одна остановка может встречаться в маршруте автобуса несколько раз,
+    // поэтому хранится множество остановок, где пассажир может оказаться
+    bool IsValidItinerary(const TransportCatalogue& catalogue, const router::Settings& settings,
+                          std::string_view from, std::string_view to, const router::RoutingResult& route) {
+        std::set<domain::StopId> current = {catalogue.FindStopByName(from)->id};
+        bool expects_wait = true;
+        double records_time = 0.;
+        for (const auto& record : route.records) {
+            records_time += record.time;
+            if (record.is_bus == expects_wait) {
+                return false;
+            }
+            expects_wait = !expects_wait;
+            if (!record.is_bus) {
+                const auto* stop = catalogue.FindStopByName(record.name);
+                if (stop == nullptr || !current.contains(stop->id) || !IsClose(record.time, settings.bus_wait_time)) {
+                    return false;
+                }
+                current = {stop->id};
+                continue;
+            }
+            const auto* bus = catalogue.FindBusByName(record.name);
+            if (bus == nullptr || record.span_count <= 0) {
+                return false;
+            }
+            std::set<domain::StopId> next;
+            const size_t span_count = static_cast<size_t>(record.span_count);
+            for (size_t position = 0; position + span_count < bus->stops.size(); ++position) {
+                if (!current.contains(bus->stops[position])) {
+                    continue;
+                }
+                double distance = 0.;
+                for (size_t segment = position; segment < position + span_count; ++segment) {
+                    distance += bus->distances[segment];
+                }
+                if (IsClose(distance / (settings.bus_velocity * 1000. / 60.), record.time)) {
+                    next.insert(bus->stops[position + span_count]);
+                }
+            }
+            if (next.empty()) {
+                return false;
+            }
+            current = std::move(next);
+        }
+        return expects_wait && current.contains(catalogue.FindStopByName(to)->id)
+            && IsClose(records_time, route.travel_time);
+    }
+
+    // Маршрут router между каждой парой остановок совпадает по времени с маршрутом reference
+    // и проходит проверку IsValidItinerary
+    void CheckSameRoutes(const TransportCatalogue& catalogue, const router::Settings& settings,
+                         const router::TransportRouter& router, const router::TransportRouter& reference,
+                         size_t stop_count, const std::string& context) {
+        size_t mismatches = 0;
+        for (size_t from = 0; from < stop_count; ++from) {
+            for (size_t to = 0; to < stop_count; ++to) {
+                const std::string from_name = GetStopName(from);
+                const std::string to_name = GetStopName(to);
+                const auto route = router.BuildRoute(from_name, to_name);
+                const auto expected = reference.BuildRoute(from_name, to_name);
+                if (route.has_value() != expected.has_value()) {
+                    ++mismatches;
+                    continue;
+                }
+                if (!route) {
+                    continue;
+                }
+                if (!IsClose(route->travel_time, expected->travel_time)
+                    || !IsValidItinerary(catalogue, settings, from_name, to_name, *route)) {
+                    ++mismatches;
+                }
+            }
+        }
+        Check(mismatches == 0, context + ": " + std::to_string(mismatches) + " routes differ");
+    }
+
+    // Маршруты, оптимальные по времени и числу пересадок, совпадают по времени и числу пересадок.
+    // Поиск по Парето не зависит от router_mode, поэтому проверяется на части пар остановок
+    void CheckSameParetoRoutes(const router::TransportRouter& router, const router::TransportRouter& reference,
+                               size_t stop_count, const std::string& context) {
+        size_t mismatches = 0;
+        for (size_t from = 0; from < stop_count; from += 7) {
+            for (size_t to = 0; to < stop_count; ++to) {
+                const auto routes = router.BuildParetoRoutes(GetStopName(from), GetStopName(to));
+                const auto expected = reference.BuildParetoRoutes(GetStopName(from), GetStopName(to));
+                if (routes.size() != expected.size()) {
+                    ++mismatches;
+                    continue;
+                }
+                for (size_t index = 0; index < routes.size(); ++index) {
+                    if (!IsClose(routes[index].travel_time, expected[index].travel_time)
+                        || routes[index].records.size() != expected[index].records.size()) {
+                        ++mismatches;
+                    }
+                }
+            }
+        }
+        Check(mismatches == 0, context + ": " + std::to_string(mismatches) + " Pareto routes differ");
+    }
+
+    const std::vector<std::pair<graph::RouterMode, std::string>> ROUTER_MODES = {
+        {graph::RouterMode::ALL_PAIRS, "all_pairs"},
+        {graph::RouterMode::ALL_PAIRS_DIJKSTRA, "all_pairs_dijkstra"},
+        {graph::RouterMode::DIJKSTRA, "dijkstra"},
+        {graph::RouterMode::BIDIRECTIONAL_ASTAR, "bidirectional_astar"},
+        {graph::RouterMode::CONTRACTION_HIERARCHY, "contraction_hierarchy"},
+    };
+
+    // Пример из README: на запрос 5 есть два маршрута по 24.21 минуты, с пересадкой на Biryulyovo Tovarnaya
+    // и на Universam. Любой режим возвращает один из них, а режим по умолчанию — пересадку на Universam
+    void TestReadmeRoute() {
+        TransportCatalogue catalogue;
+        // Ссылки на остановки меняются при добавлении следующих, поэтому запоминаются номера
+        const domain::StopId zapadnoye = catalogue.AddStop("Biryulyovo Zapadnoye", geo::Coordinates{55.574371, 37.6517}).id;
+        const domain::StopId universam = catalogue.AddStop("Universam", geo::Coordinates{55.587655, 37.645687}).id;
+        const domain::StopId tovarnaya = catalogue.AddStop("Biryulyovo Tovarnaya", geo::Coordinates{55.592028, 37.653656}).id;
+        const domain::StopId prazhskaya = catalogue.AddStop("Prazhskaya", geo::Coordinates{55.611717, 37.603938}).id;
+        catalogue.SetStopDistance(zapadnoye, tovarnaya, 2600);
+        catalogue.SetStopDistance(universam, tovarnaya, 1380);
+        catalogue.SetStopDistance(universam, zapadnoye, 2500);
+        catalogue.SetStopDistance(universam, prazhskaya, 4650);
+        catalogue.SetStopDistance(tovarnaya, universam, 890);
+        catalogue.AddBus("297", true, std::vector{zapadnoye, tovarnaya, universam, zapadnoye});
+        catalogue.AddBus("635", false, std::vector{tovarnaya, universam, prazhskaya, universam, tovarnaya});
+        catalogue.Finalize();
+
+        const router::Settings settings{.bus_velocity = 40., .bus_wait_time = 6};
+        for (const auto& [mode, name] : ROUTER_MODES) {
+            router::Settings mode_settings = settings;
+            mode_settings.router_mode = mode;
+            const auto route = router::TransportRouter(catalogue, mode_settings)
+                .BuildRoute("Biryulyovo Zapadnoye", "Prazhskaya");
+            Check(route && IsClose(route->travel_time, 24.21) && route->records.size() == 4
+                      && IsValidItinerary(catalogue, mode_settings, "Biryulyovo Zapadnoye", "Prazhskaya", *route),
+                  "README route, " + name);
+        }
+
+        const auto route = router::TransportRouter(catalogue, settings).BuildRoute("Biryulyovo Zapadnoye", "Prazhskaya");
+        const std::vector<router::RouteInfo> expected = {
+            {false, "Biryulyovo Zapadnoye", 0, 6.},
+            {true, "297", 2, 5.235},
+            {false, "Universam", 0, 6.},
+            {true, "635", 1, 6.975},
+        };
+        bool is_expected = route && route->records.size() == expected.size();
+        for (size_t index = 0; is_expected && index < expected.size(); ++index) {
+            const auto& record = route->records[index];
+            is_expected = record.is_bus == expected[index].is_bus && record.name == expected[index].name
+                && (!record.is_bus || record.span_count == expected[index].span_count)
+                && IsClose(record.time, expected[index].time);
+        }
+        Check(is_expected, "README route, default mode items");
+    }
+
+    // При нулевом времени ожидания рёбра посадки и высадки образуют циклы нулевого веса.
+    // Сеть больше блока Флойда — Уоршелла, чтобы работали все фазы блочного алгоритма
+    void TestZeroWaitTime() {
+        constexpr size_t STOP_COUNT = 120;
+        TransportCatalogue catalogue;
+        FillNetwork(catalogue, 2, STOP_COUNT, 40);
+        const router::Settings settings{.bus_velocity = 20., .bus_wait_time = 0,
+                                        .router_mode = graph::RouterMode::DIJKSTRA};
+        const router::TransportRouter reference(catalogue, settings);
+        for (const auto& [mode, name] : ROUTER_MODES) {
+            router::Settings mode_settings = settings;
+            mode_settings.router_mode = mode;
+            CheckSameRoutes(catalogue, mode_settings, router::TransportRouter(catalogue, mode_settings), reference,
+                            STOP_COUNT, "zero wait time, " + name);
+        }
+    }
+
+    // Обновление весов на месте даёт те же ответы, что и маршрутизатор, построенный заново:
+    // в режимах ALL_PAIRS* чинятся строки таблицы, иерархия сжатия строится заново,
+    // у A* обновляются обратный граф и эвристика. Новые настройки делают перегоны дороже,
+    // а ожидание — нулевым; из двух перегонов один становится длиннее, другой — короче
+    void TestUpdatesMatchRebuild() {
+        constexpr size_t STOP_COUNT = 100;
+        for (const auto& [mode, name] : ROUTER_MODES) {
+            TransportCatalogue catalogue;
+            FillNetwork(catalogue, 3, STOP_COUNT, 30);
+            router::TransportRouter router(catalogue, router::Settings{.bus_velocity = 30., .bus_wait_time = 6,
+                                                                       .router_mode = mode});
+
+            const router::Settings updated{.bus_velocity = 20., .bus_wait_time = 0, .router_mode = mode};
+            router.UpdateSettings(updated.bus_velocity, updated.bus_wait_time);
+            const router::TransportRouter rebuilt(catalogue, updated);
+            CheckSameRoutes(catalogue, updated, router, rebuilt, STOP_COUNT, name + ", updated settings");
+            CheckSameParetoRoutes(router, rebuilt, STOP_COUNT, name + ", updated settings");
+
+            for (const auto& [bus_id, distance] : {std::pair{0u, 20000}, std::pair{1u, 1}}) {
+                const auto& bus = catalogue.GetBus(bus_id);
+                const auto& from = catalogue.GetStop(bus.stops[0]);
+                const auto& to = catalogue.GetStop(bus.stops[1]);
+                catalogue.SetStopDistance(from.id, to.id, distance);
+                router.UpdateStopDistance(from.stop_name, to.stop_name);
+            }
+            const router::TransportRouter rebuilt_after_distances(catalogue, updated);
+            CheckSameRoutes(catalogue, updated, router, rebuilt_after_distances, STOP_COUNT, name + ", updated distances");
+            CheckSameParetoRoutes(router, rebuilt_after_distances, STOP_COUNT, name + ", updated distances");
+        }
+    }
+} // namespace
+
+int main() {
+    TestReadmeRoute();
+    TestZeroWaitTime();
+    TestUpdatesMatchRebuild();
+    if (failures != 0) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All router tests passed" << std::endl;
+    return 0;
+}
@@ -1,11 +1,15 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace transport_catalogue {
-    std::set<Stop*, StopComparator> TransportCatalogue::GetAllStopsWithBus() const {
-        std::set<Stop*, StopComparator> stops;
-        for (const auto& stop : buses_to_stop_) {
-            if (!stop.second.empty()) {
-                stops.insert(FindStopByName(stop.first));
+    std::set<const Stop*, StopComparator> TransportCatalogue::GetAllStopsWithBus() const {
+        CheckFinalized();
+        std::set<const Stop*, StopComparator> stops;
+        for (const auto& stop : stops_) {
+            if (!GetStopBuses(stop.id).empty()) {
+                stops.insert(&stop);
             }
         }
         return stops;
@@ -19,9 +23,10 @@ namespace transport_catalogue {
         return sorted_buses;
     }
     std::vector<geo::Coordinates> TransportCatalogue::GetAllStopsCoordinates() const {
+        CheckFinalized();
         std::vector<geo::Coordinates> geo_coord;
         for (const auto& stop : stops_) {
-            if(!GetStopInfo(stop.stop_name).buses.empty()) {
+            if(!GetStopBuses(stop.id).empty()) {
                 geo_coord.push_back(stop.coordinates);    
             }
         }
@@ -32,64 +37,143 @@ namespace transport_catalogue {
         auto itl = index_stops_.find(stop);
 
         for (const auto& [distance, neighbor_stop] : distances_stops) {
-            stops_distance_[std::make_pair((*itl).second, (*index_stops_.find(neighbor_stop)).second)] = distance;
+            stops_distance_[MakeDistanceKey((*itl).second, (*index_stops_.find(neighbor_stop)).second)] = distance;
         }
     }
 
-    void TransportCatalogue::AddStop(const Stop& stop) {
-        stops_.push_back(stop);
-        index_stops_[stops_.back().stop_name] = &stops_.back();
+    TransportCatalogue::TransportCatalogue(NameStorage name_storage)
+        : name_storage_(name_storage) {
     }
 
-    void TransportCatalogue::AddBus(const Bus& bus) {
-        buses_.push_back(bus);
-        auto added_bus = &buses_.back();
-        index_buses_[buses_.back().bus_name] = added_bus;
+    const Stop& TransportCatalogue::AddStop(std::string_view name, geo::Coordinates coordinates) {
+        if (finalized_) {
+            throw std::logic_error("Catalogue is finalized");
+        }
+        const auto id = static_cast<StopId>(stops_.size());
+        stops_.push_back(Stop{id, StoreName(name), coordinates});
+        index_stops_[stops_.back().stop_name] = id;
+        return stops_.back();
+    }
 
-        for (const auto stop : bus.stops) {
-            buses_to_stop_[stop->stop_name].emplace(added_bus->bus_name);
+    std::string_view TransportCatalogue::StoreName(std::string_view name) {
+        return name_storage_ == NameStorage::COPY ? names_.Store(name) : name;
+    }
+
+    const Bus& TransportCatalogue::AddBus(std::string_view name, bool is_roundtrip, std::span<const StopId> stops,
+                                         std::span<const double> departures) {
+        if (finalized_) {
+            throw std::logic_error("Catalogue is finalized");
+        }
+        const StopId* route_data = route_stops_.data();
+        const int* distances_data = route_distances_.data();
+        const double* departures_data = route_departures_.data();
+        const size_t distance_count = stops.empty() ? 0 : stops.size() - 1;
+        route_stops_.insert(route_stops_.end(), stops.begin(), stops.end());
+        route_distances_.resize(route_distances_.size() + distance_count);
+        route_departures_.insert(route_departures_.end(), departures.begin(), departures.end());
+        // Массивы маршрутов переехали: срезы уже добавленных автобусов идут в них подряд
+        if (route_stops_.data() != route_data || route_distances_.data() != distances_data
+            || route_departures_.data() != departures_data) {
+            size_t stops_offset = 0;
+            size_t distances_offset = 0;
+            size_t departures_offset = 0;
+            for (auto& bus : buses_) {
+                bus.stops = std::span<const StopId>(route_stops_.data() + stops_offset, bus.stops.size());
+                bus.distances = std::span<const int>(route_distances_.data() + distances_offset, bus.distances.size());
+                bus.departures = std::span<const double>(route_departures_.data() + departures_offset,
+                                                         bus.departures.size());
+                stops_offset += bus.stops.size();
+                distances_offset += bus.distances.size();
+                departures_offset += bus.departures.size();
+            }
         }
+
+        const auto id = static_cast<BusId>(buses_.size());
+        buses_.push_back(Bus{
+            .id = id,
+            .is_roundtrip = is_roundtrip,
+            .bus_name = StoreName(name),
+            .stops = std::span<const StopId>(route_stops_.data() + route_stops_.size() - stops.size(), stops.size()),
+            .distances = std::span<const int>(route_distances_.data() + route_distances_.size() - distance_count,
+                                              distance_count),
+            .departures = std::span<const double>(route_departures_.data() + route_departures_.size() - departures.size(),
+                                                  departures.size())
+        });
+        const Bus& added_bus = buses_.back();
+        index_buses_[added_bus.bus_name] = id;
+        return added_bus;
     }
 
-    Bus* TransportCatalogue::FindBusByName(std::string_view name) const {
+    const Bus* TransportCatalogue::FindBusByName(std::string_view name) const {
         auto it = index_buses_.find(name);
         if(it == index_buses_.end()) {
             return nullptr;
         }
-        return (*it).second;
+        return &buses_[(*it).second];
     }
 
-    Stop* TransportCatalogue::FindStopByName(std::string_view name) const {
+    const Stop* TransportCatalogue::FindStopByName(std::string_view name) const {
         auto it = index_stops_.find(name);
         if (it == index_stops_.end())         {
             return nullptr;
         }
-        return (*it).second;
+        return &stops_[(*it).second];
+    }
+
+    const Stop& TransportCatalogue::GetStop(StopId id) const {
+        return stops_.at(id);
+    }
+
+    const Bus& TransportCatalogue::GetBus(BusId id) const {
+        return buses_.at(id);
+    }
+
+    size_t TransportCatalogue::GetStopCount() const {
+        return stops_.size();
+    }
+
+    // Один проход по маршруту: дорожная и географическая длины считаются вместе
+    TransportCatalogue::BusStats TransportCatalogue::ComputeBusStats(const Bus& bus) const {
+        std::vector<StopId> unique_stops(bus.stops.begin(), bus.stops.end());
+        std::sort(unique_stops.begin(), unique_stops.end());
+        BusStats stats;
+        stats.unique_stops = std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
+
+        double geo_distance = 0.;
+        for (size_t stop = 0; stop + 1 < bus.stops.size(); ++stop) {
+            stats.distance += bus.distances[stop];
+            geo_distance += ComputeDistance(stops_[bus.stops[stop]].coordinates,
+                                            stops_[bus.stops[stop + 1]].coordinates);
+        }
+        stats.curvature = static_cast<double>(stats.distance) / geo_distance;
+        return stats;
     }
 
-    size_t TransportCatalogue::CountUniqueStopsByBus(Bus* bus) const { 
-        std::unordered_set<Stop*> unique_stops;
-        for (const auto stop : bus->stops) {
-            unique_stops.insert(stop);
+    void TransportCatalogue::UpdateRouteDistances(const Bus& bus) {
+        int* distances = route_distances_.data() + (bus.distances.data() - route_distances_.data());
+        for (size_t stop = 0; stop < bus.distances.size(); ++stop) {
+            distances[stop] = GetStopDistance(bus.stops[stop], bus.stops[stop + 1]);
         }
-        return unique_stops.size();
     }
 
-    double  TransportCatalogue::GetBusDistance(Bus* bus) const  {
-        double distance = 0.;
-        for (auto it = bus->stops.cbegin(); it != bus->stops.cend() - 1; ++it) {
-            auto it_next = next(it);
-            distance += ComputeDistance((*it)->coordinates, (*it_next)->coordinates);
+    // Пересчитывает расстояния перегонов и статистику автобусов, проходящих через остановку.
+    // До Finalize пересчитывать нечего: всё посчитается при заморозке
+    void TransportCatalogue::UpdateBusRoutes(StopId stop) {
+        if (!finalized_) {
+            return;
+        }
+        for (const BusId id : GetStopBuses(stop)) {
+            UpdateRouteDistances(buses_[id]);
+            bus_stats_[id] = ComputeBusStats(buses_[id]);
         }
-        return distance;
     }
 
     BusInfo TransportCatalogue::GetBusInfo(std::string_view bus_name) const {
         using namespace std;
+        CheckFinalized();
 
-        string info;
-        auto bus = FindBusByName(bus_name);
-        if (bus == nullptr) {
+        auto it = index_buses_.find(bus_name);
+        if (it == index_buses_.end()) {
             BusInfo bus_info{ 
                 .exists = false,
                 .name = bus_name,
@@ -101,60 +185,27 @@ namespace transport_catalogue {
             return bus_info;
         }
 
-        size_t unique_stops = CountUniqueStopsByBus(bus);
-
-        int distance = GetBusFactDistance (bus);
-        double curvature = CalculateCurvature(bus);
-
+        const BusStats& stats = bus_stats_[it->second];
         BusInfo bus_info{
             .exists = true,
             .name = bus_name,
-            .stops = bus->stops.size(),
-            .unique_stops = unique_stops,
-            .distance = distance,
-            .curvature = curvature 
+            .stops = buses_[it->second].stops.size(),
+            .unique_stops = stats.unique_stops,
+            .distance = stats.distance,
+            .curvature = stats.curvature
         };
 
         return bus_info;
     }
 
-    int TransportCatalogue::GetBusFactDistance(Bus* bus) const {
-        int distance = 0;
-        for (size_t stop = 0; stop + 1 < bus->stops.size(); ++stop) {
-            auto it = stops_distance_.find(std::make_pair(bus->stops[stop], bus->stops[stop + 1]));
-
-            if (it == stops_distance_.end()) {
-                it = stops_distance_.find(std::make_pair(bus->stops[stop + 1], bus->stops[stop]));
-            }
-
-            distance += it->second;
-        }
-        return distance;
-    }
-
-    double TransportCatalogue::CalculateCurvature(Bus* bus) const {
-        return static_cast<double>(GetBusFactDistance(bus)) / GetBusDistance(bus);
-    }
-
     StopInfo TransportCatalogue::GetStopInfo(std::string_view stop_name) const {
-        using namespace std;
-
+        CheckFinalized();
         auto stop = FindStopByName(stop_name);
         if (stop == nullptr) {
             StopInfo stop_info{
                 .exists = false,
                 .name = stop_name,
-                .buses = std::set<std::string_view>()
-            };
-            return stop_info;
-        }
-
-        const auto it = buses_to_stop_.find(stop_name);
-        if (it == buses_to_stop_.end()) {
-            StopInfo stop_info{
-                .exists = true,
-                .name = stop_name,
-                .buses = std::set<std::string_view>()
+                .buses = {}
             };
             return stop_info;
         }
@@ -162,25 +213,93 @@ namespace transport_catalogue {
         StopInfo stop_info{
             .exists = true,
             .name = stop_name,
-            .buses = std::set<std::string_view>()
+            .buses = GetStopBuses(stop->id)
         };
-        for (const auto bus_name : (*it).second) {
-            stop_info.buses.insert(bus_name);
+        return stop_info;
+    }
+
+    std::span<const BusId> TransportCatalogue::GetStopBuses(StopId stop) const {
+        return std::span<const BusId>(stop_buses_.data() + stop_bus_offsets_[stop],
+                                      stop_bus_offsets_[stop + 1] - stop_bus_offsets_[stop]);
+    }
+
+    // Автобусы раскладываются по остановкам в порядке названий, поэтому список каждой
+    // остановки получается отсортированным, а повторные заезды автобуса идут подряд
+    void TransportCatalogue::Finalize() {
+        if (finalized_) {
+            return;
+        }
+        bus_stats_.clear();
+        bus_stats_.reserve(buses_.size());
+        for (const auto& bus : buses_) {
+            UpdateRouteDistances(bus);
+            bus_stats_.push_back(ComputeBusStats(bus));
         }
 
-        return stop_info;
+        std::vector<BusId> sorted_buses(buses_.size());
+        std::iota(sorted_buses.begin(), sorted_buses.end(), BusId{0});
+        std::sort(sorted_buses.begin(), sorted_buses.end(), [this](BusId lhs, BusId rhs) {
+            return buses_[lhs].bus_name < buses_[rhs].bus_name;
+        });
+
+        constexpr BusId NO_BUS = std::numeric_limits<BusId>::max();
+        std::vector<BusId> last_buses(stops_.size(), NO_BUS);
+        stop_bus_offsets_.assign(stops_.size() + 1, 0);
+        for (const BusId bus : sorted_buses) {
+            for (const StopId stop : buses_[bus].stops) {
+                if (last_buses[stop] != bus) {
+                    last_buses[stop] = bus;
+                    ++stop_bus_offsets_[stop + 1];
+                }
+            }
+        }
+        for (size_t stop = 0; stop < stops_.size(); ++stop) {
+            stop_bus_offsets_[stop + 1] += stop_bus_offsets_[stop];
+        }
+
+        stop_buses_.resize(stop_bus_offsets_.back());
+        std::vector<uint32_t> positions(stop_bus_offsets_.begin(), stop_bus_offsets_.end() - 1);
+        last_buses.assign(stops_.size(), NO_BUS);
+        for (const BusId bus : sorted_buses) {
+            for (const StopId stop : buses_[bus].stops) {
+                if (last_buses[stop] != bus) {
+                    last_buses[stop] = bus;
+                    stop_buses_[positions[stop]++] = bus;
+                }
+            }
+        }
+        finalized_ = true;
+    }
+
+    bool TransportCatalogue::IsFinalized() const {
+        return finalized_;
+    }
+
+    void TransportCatalogue::CheckFinalized() const {
+        if (!finalized_) {
+            throw std::logic_error("Catalogue is not finalized");
+        }
     }
 
     void TransportCatalogue::AddAllDistancesToStops(std::unordered_map<std::string, std::vector<std::pair<int, std::string>>> stop_to_distances) {
         for (const auto& stop : stop_to_distances) {
             AddStopDistances(stop.first, std::move(stop.second));
         }
+        // До Finalize маршруты ещё не посчитаны, после — пересчитываются целиком
+        if (!finalized_) {
+            return;
+        }
+        for (BusId id = 0; id < buses_.size(); ++id) {
+            UpdateRouteDistances(buses_[id]);
+            bus_stats_[id] = ComputeBusStats(buses_[id]);
+        }
     }
 
-    int TransportCatalogue::GetStopDistance(const Stop* from, const Stop* to) const {
-        std::pair<Stop*, Stop*> key1 = {const_cast<Stop*>(from), const_cast<Stop*>(to)};
-        std::pair<Stop*, Stop*> key2 = {const_cast<Stop*>(to), const_cast<Stop*>(from)};
-        
+    int TransportCatalogue::GetStopDistance(StopId from, StopId to) const {
+        const uint64_t key1 = MakeDistanceKey(from, to);
+        const uint64_t key2 = MakeDistanceKey(to, from);
+
+
         if (auto it = stops_distance_.find(key1); it != stops_distance_.end()) {
             return it->second;
         }
@@ -189,4 +308,18 @@ namespace transport_catalogue {
         }
         return 0;
     }
+
+    void TransportCatalogue::SetStopDistance(StopId from, StopId to, int distance) {
+        stops_distance_[MakeDistanceKey(from, to)] = distance;
+        UpdateBusRoutes(from);
+    }
+
+    void TransportCatalogue::SetStopCoordinates(StopId stop, geo::Coordinates coordinates) {
+        stops_.at(stop).coordinates = coordinates;
+        UpdateBusRoutes(stop);
+    }
+
+    uint64_t TransportCatalogue::MakeDistanceKey(StopId from, StopId to) {
+        return static_cast<uint64_t>(from) << 32 | to;
+    }
 } // namespace transport_catalogue
\ No newline at end of file
@@ -1,54 +1,105 @@
 #pragma once
-#include <deque>
+#include <cstdint>
 #include <set>
+#include <span>
 #include <string>
 #include <string_view>
 #include <sstream>
+#include <stdexcept>
 #include <numeric>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include "geo.h"
 #include "domain.h"
+#include "string_arena.h"
 
 namespace transport_catalogue {
 	using namespace domain;
+
+	// Где хранятся имена остановок и автобусов
+	enum class NameStorage {
+		COPY,		// имена копируются в хранилище строк справочника
+		REFERENCE	// справочник хранит string_view переданных строк: они должны жить дольше справочника
+	};
+
+	// После Finalize справочник только читается: константные методы не меняют состояния
+	// и могут вызываться из нескольких потоков одновременно. SetStopDistance и SetStopCoordinates
+	// после Finalize требуют, чтобы в это время никто не читал справочник
 	class TransportCatalogue {
 
 	public:
-		void AddStop(const Stop& stop);
-		void AddBus(const Bus& bus);
-		Bus* FindBusByName(std::string_view name) const;
-		Stop* FindStopByName(std::string_view name) const;
+		explicit TransportCatalogue(NameStorage name_storage = NameStorage::COPY);
+
+		// Имена сохраняются согласно NameStorage. Остановки и автобусы лежат в непрерывных
+		// массивах, поэтому указатели и ссылки на них действительны до следующего добавления
+		// объекта того же вида; номера не меняются никогда.
+		const Stop& AddStop(std::string_view name, geo::Coordinates coordinates);
+		const Bus& AddBus(std::string_view name, bool is_roundtrip, std::span<const StopId> stops,
+		                  std::span<const double> departures = {});
+		// Заполняет расстояния перегонов и статистику маршрутов и строит индекс остановка -> автобусы.
+		// До вызова остановки, расстояния и автобусы можно добавлять в любом порядке, после него
+		// добавлять остановки и автобусы нельзя. GetBusInfo, GetStopInfo, GetAllStopsWithBus
+		// и GetAllStopsCoordinates доступны только после него
+		void Finalize();
+		bool IsFinalized() const;
+		const Bus* FindBusByName(std::string_view name) const;
+		const Stop* FindStopByName(std::string_view name) const;
+		const Stop& GetStop(StopId id) const;
+		const Bus& GetBus(BusId id) const;
+		size_t GetStopCount() const;
 		BusInfo GetBusInfo(std::string_view bus_name) const;
 		StopInfo GetStopInfo(std::string_view stop_name) const;
 		void AddAllDistancesToStops(std::unordered_map<std::string, std::vector<std::pair<int, std::string>>> stop_to_distances);
 		std::set<const Bus*, BusComparator> GetAllBuses() const;
 		std::vector<geo::Coordinates> GetAllStopsCoordinates() const;
-		std::set<Stop*, StopComparator> GetAllStopsWithBus() const;
-		int GetStopDistance(const Stop* from, const Stop* to) const;
+		std::set<const Stop*, StopComparator> GetAllStopsWithBus() const;
+		int GetStopDistance(StopId from, StopId to) const;
+		// Задаёт расстояние from -> to. Направление to -> from без собственного значения тоже меняется
+		void SetStopDistance(StopId from, StopId to, int distance);
+		void SetStopCoordinates(StopId stop, geo::Coordinates coordinates);
 
 	private:
-	    struct StopsHasher {
-			size_t operator()(const std::pair<Stop*, Stop*>& p) const {
-				size_t hash1 = std::hash<Stop*>()(p.first);
-				size_t hash2 = std::hash<Stop*>()(p.second);
-
-				return hash1 * 17 + hash2;
-			}
+		// Статистика маршрута для запросов Bus: считается в Finalize
+		// и пересчитывается вместе с расстояниями перегонов
+		struct BusStats {
+			size_t unique_stops = 0;
+			int distance = 0;
+			double curvature = 0.;
 		};
-		
-		std::deque<Stop> stops_;
-		std::deque<Bus> buses_;
-		std::unordered_map<std::string_view, Stop*> index_stops_;
-		std::unordered_map<std::string_view, Bus*> index_buses_;
-		std::unordered_map<std::string_view, std::set<std::string_view>> buses_to_stop_;
-		std::unordered_map<std::pair<Stop*, Stop*>, int, StopsHasher> stops_distance_;
-		
-		size_t CountUniqueStopsByBus(Bus* bus) const;
-		double  GetBusDistance(Bus* bus) const;
-		int GetBusFactDistance(Bus* bus) const;
+
+		std::string_view StoreName(std::string_view name);
+
+		NameStorage name_storage_;
+		StringArena names_;
+		std::vector<Stop> stops_;
+		std::vector<Bus> buses_;
+		// Индекс — BusId
+		std::vector<BusStats> bus_stats_;
+		// Маршруты всех автобусов подряд в порядке добавления, stops автобуса — срез этого массива
+		std::vector<StopId> route_stops_;
+		// Расстояния перегонов маршрутов в том же порядке, distances автобуса — срез этого массива.
+		// Обратное направление подставляется при заполнении, поэтому на горячих путях
+		// расстояние читается из массива без поиска
+		std::vector<int> route_distances_;
+		// Отправления рейсов всех автобусов в том же порядке, departures автобуса — срез этого массива
+		std::vector<double> route_departures_;
+		std::unordered_map<std::string_view, StopId> index_stops_;
+		std::unordered_map<std::string_view, BusId> index_buses_;
+		bool finalized_ = false;
+		// Автобусы через остановку stop — [stop_bus_offsets_[stop], stop_bus_offsets_[stop + 1])
+		// в stop_buses_, по возрастанию названий и без повторов
+		std::vector<uint32_t> stop_bus_offsets_;
+		std::vector<BusId> stop_buses_;
+		// Расстояния в том виде, как заданы: ключ — пара номеров остановок в одном числе
+		std::unordered_map<uint64_t, int> stops_distance_;
+
+		static uint64_t MakeDistanceKey(StopId from, StopId to);
+		BusStats ComputeBusStats(const Bus& bus) const;
+		void UpdateRouteDistances(const Bus& bus);
+		void UpdateBusRoutes(StopId stop);
+		std::span<const BusId> GetStopBuses(StopId stop) const;
+		void CheckFinalized() const;
 		void AddStopDistances(std::string_view stop, std::vector<std::pair<int, std::string>> distances_to_stops);
-		double CalculateCurvature(Bus* bus) const;
 	};
 } // namespace transport_catalogue
\ No newline at end of file
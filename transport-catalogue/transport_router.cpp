@@ -1,12 +1,205 @@
 #include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
 namespace router {
+    namespace {
+        // Расстояние по дуге большого круга; для совпадающих точек acos может вернуть NaN
+        double GreatCircleDistance(geo::Coordinates from, geo::Coordinates to) {
+            if (from == to) {
+                return 0.;
+            }
+            const double distance = geo::ComputeDistance(from, to);
+            return std::isnan(distance) ? 0. : distance;
+        }
+    } // namespace
+
     TransportRouter::TransportRouter(const transport_catalogue::TransportCatalogue& catalogue, router::Settings settings)
         :   catalogue_(catalogue),
-            settings_(settings),
-            graph_(catalogue.GetAllStopsWithBus().size() * 2) {
+            settings_(settings) {
 
             BuildGraph();
-            router_ = std::make_unique<graph::Router<double>>(graph_);
+
+            router_ = std::make_unique<graph::Router<double>>(graph_, settings_.router_mode, MakeHeuristic(),
+                                                              settings_.preprocessing_threads);
+    }
+
+    void TransportRouter::UpdateSettings(double bus_velocity, int bus_wait_time) {
+        settings_.bus_velocity = bus_velocity;
+        settings_.bus_wait_time = bus_wait_time;
+
+        std::vector<graph::Router<double>::EdgeWeightChange> changes;
+        for (graph::EdgeId edge_id = 0; edge_id < edges_info_.size(); ++edge_id) {
+            if (edges_info_[edge_id].type == EdgeType::WAIT) {
+                SetEdgeWeight(edge_id, static_cast<double>(bus_wait_time), changes);
+            }
+        }
+        size_t segment = 0;
+        for (const auto* bus : buses_) {
+            for (size_t position = 0; position + 1 < bus->stops.size(); ++position) {
+                SetEdgeWeight(ride_edges_[segment++], GetSegmentTime(*bus, position), changes);
+            }
+        }
+        ApplyWeightChanges(changes);
+    }
+
+    void TransportRouter::UpdateStopDistance(std::string_view from, std::string_view to) {
+        std::vector<graph::Router<double>::EdgeWeightChange> changes;
+        size_t segment = 0;
+        for (const auto* bus : buses_) {
+            for (size_t position = 0; position + 1 < bus->stops.size(); ++position, ++segment) {
+                const std::string_view first = catalogue_.GetStop(bus->stops[position]).stop_name;
+                const std::string_view second = catalogue_.GetStop(bus->stops[position + 1]).stop_name;
+                if ((first == from && second == to) || (first == to && second == from)) {
+                    SetEdgeWeight(ride_edges_[segment], GetSegmentTime(*bus, position), changes);
+                }
+            }
+        }
+        ApplyWeightChanges(changes);
+    }
+
+    void TransportRouter::SetEdgeWeight(graph::EdgeId edge_id, double weight,
+                                        std::vector<graph::Router<double>::EdgeWeightChange>& changes) {
+        const double old_weight = graph_.GetEdge(edge_id).weight;
+        if (old_weight != weight) {
+            graph_.SetEdgeWeight(edge_id, weight);
+            changes.push_back({edge_id, old_weight});
+        }
+    }
+
+    void TransportRouter::ApplyWeightChanges(const std::vector<graph::Router<double>::EdgeWeightChange>& changes) {
+        if (changes.empty()) {
+            return;
+        }
+        router_->UpdateEdgeWeights(changes);
+        ComputeTripOffsets();
+        if (settings_.router_mode == graph::RouterMode::BIDIRECTIONAL_ASTAR) {
+            router_->SetHeuristic(MakeHeuristic());
+        }
+        // Ещё не построенный RAPTOR возьмёт новые времена при построении
+        if (raptor_) {
+            raptor_->UpdateTimes(buses_, settings_.bus_velocity, settings_.bus_wait_time);
+        }
+    }
+
+    const RaptorRouter& TransportRouter::GetRaptor() const {
+        std::call_once(raptor_built_, [this] {
+            raptor_ = std::make_unique<RaptorRouter>(catalogue_, stops_, buses_, settings_.bus_velocity,
+                                                     settings_.bus_wait_time);
+        });
+        return *raptor_;
+    }
+
+    graph::Router<double>::Heuristic TransportRouter::MakeHeuristic() const {
+        if (settings_.router_mode != graph::RouterMode::BIDIRECTIONAL_ASTAR) {
+            return {};
+        }
+        // Время в пути не меньше расстояния по прямой, делённого на наибольшую скорость
+        const double speed = GetHeuristicSpeed();
+        if (speed <= 0.) {
+            return {};
+        }
+        return [coordinates = vertex_coordinates_, speed](graph::VertexId from, graph::VertexId to) {
+            return GreatCircleDistance(coordinates[from], coordinates[to]) / speed;
+        };
+    }
+
+    std::optional<RoutingResult> TransportRouter::BuildRoute(std::string_view from, std::string_view to,
+                                                             size_t max_transfers) const {
+        auto routes = BuildParetoRoutes(from, to, max_transfers);
+        if (routes.empty()) {
+            return std::nullopt;
+        }
+        // Время по раундам только убывает, последний маршрут — самый быстрый
+        return std::move(routes.back());
+    }
+
+    std::vector<RoutingResult> TransportRouter::BuildParetoRoutes(std::string_view from, std::string_view to,
+                                                                  std::optional<size_t> max_transfers) const {
+        auto from_it = stop_to_vertex_.find(from);
+        auto to_it = stop_to_vertex_.find(to);
+        if (from_it == stop_to_vertex_.end() || to_it == stop_to_vertex_.end()) {
+            return {};
+        }
+
+        std::vector<RoutingResult> routes;
+        const auto journeys = GetRaptor().BuildJourneys(static_cast<uint32_t>(from_it->second),
+                                                        static_cast<uint32_t>(to_it->second), max_transfers);
+        routes.reserve(journeys.size());
+        for (const auto& journey : journeys) {
+            routes.push_back(MakeRoutingResult(journey));
+        }
+        return routes;
+    }
+
+    std::vector<std::vector<std::optional<double>>> TransportRouter::ComputeTravelTimes(
+            const std::vector<std::string_view>& from, const std::vector<std::string_view>& to) const {
+        std::vector<std::optional<graph::VertexId>> to_vertices;
+        to_vertices.reserve(to.size());
+        for (const auto stop : to) {
+            const auto it = stop_to_vertex_.find(stop);
+            to_vertices.push_back(it == stop_to_vertex_.end() ? std::nullopt : std::optional{it->second});
+        }
+
+        std::vector<std::vector<std::optional<double>>> times;
+        times.reserve(from.size());
+        for (const auto stop : from) {
+            auto& row = times.emplace_back(to.size());
+            const auto it = stop_to_vertex_.find(stop);
+            if (it == stop_to_vertex_.end()) {
+                continue;
+            }
+            const auto weights = router_->BuildWeightsFrom(it->second);
+            for (size_t index = 0; index < to_vertices.size(); ++index) {
+                if (to_vertices[index]) {
+                    row[index] = weights[*to_vertices[index]];
+                }
+            }
+        }
+        return times;
+    }
+
+    std::optional<std::vector<std::pair<std::string_view, double>>> TransportRouter::ComputeIsochrone(
+            std::string_view from, double max_time) const {
+        const auto it = stop_to_vertex_.find(from);
+        if (it == stop_to_vertex_.end()) {
+            return std::nullopt;
+        }
+        const auto weights = router_->BuildWeightsFrom(it->second, max_time);
+
+        std::vector<std::pair<std::string_view, double>> stops;
+        for (graph::VertexId vertex = 0; vertex < stops_.size(); ++vertex) {
+            if (weights[vertex]) {
+                stops.emplace_back(stops_[vertex]->stop_name, *weights[vertex]);
+            }
+        }
+        std::sort(stops.begin(), stops.end(), [](const auto& lhs, const auto& rhs) {
+            return std::tie(lhs.second, lhs.first) < std::tie(rhs.second, rhs.first);
+        });
+        return stops;
+    }
+
+    RoutingResult TransportRouter::MakeRoutingResult(const RaptorJourney& journey) const {
+        RoutingResult route{};
+        route.travel_time = journey.travel_time;
+        for (const auto& leg : journey.legs) {
+            route.records.emplace_back(RouteInfo{
+                .is_bus = false,
+                .name = std::string(stops_[leg.board_stop]->stop_name),
+                .span_count = 0,
+                .time = static_cast<double>(settings_.bus_wait_time)
+            });
+            route.records.emplace_back(RouteInfo{
+                .is_bus = true,
+                .name = std::string(buses_[leg.bus]->bus_name),
+                .span_count = leg.span_count,
+                .time = leg.ride_time
+            });
+        }
+        return route;
     }
 
     std::optional<RoutingResult> TransportRouter::BuildRoute(std::string_view from, std::string_view to) const {
@@ -27,29 +220,100 @@ namespace router {
         if (!route_info) {
             return std::nullopt;
         };
-        route.travel_time = route_info->weight;
-
-        for (const auto& id : route_info->edges) {
-            const graph::Edge<double> route_edge = graph_.GetEdge(id);
-            // Ожидание - если остановки соседние и вес равен времени ожидания
-            if (route_edge.from + 1 == route_edge.to && domain::IsSame(route_edge.weight, settings_.bus_wait_time)) {
-                // Ожидание
-                route.records.emplace_back(RouteInfo{
-                    .is_bus = false,
-                    .name = std::string(vertex_to_stop_.at(route_edge.from)),
-                    .span_count = 0u,
-                    .time = static_cast<double>(settings_.bus_wait_time)
-                });
+        return MakeRoutingResult(*route_info, std::nullopt);
+    }
+
+    std::optional<RoutingResult> TransportRouter::BuildRouteDepartingAt(std::string_view from, std::string_view to,
+                                                                        double departure_time) const {
+        auto from_it = stop_to_vertex_.find(from);
+        auto to_it = stop_to_vertex_.find(to);
+        if (from_it == stop_to_vertex_.end() || to_it == stop_to_vertex_.end()) {
+            return std::nullopt;
+        }
+
+        auto route_info = router_->BuildRouteDepartingAt(from_it->second, to_it->second, departure_time,
+            [this](graph::EdgeId edge_id, double entry_time) {
+                return GetEdgeTravelTime(edge_id, entry_time);
+            });
+        if (!route_info) {
+            return std::nullopt;
+        }
+        return MakeRoutingResult(*route_info, departure_time);
+    }
+
+    // Для рейсов по расписанию ожидание длится до ближайшего отправления рейса с этой позиции маршрута,
+    // остальные рёбра проходятся за свой постоянный вес
+    double TransportRouter::GetEdgeTravelTime(graph::EdgeId edge_id, double entry_time) const {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edges_info_[edge_id].type != EdgeType::WAIT) {
+            return edge.weight;
+        }
+        const size_t position = edge.to - stops_.size();
+        const auto& departures = buses_[position_buses_[position]]->departures;
+        if (departures.empty()) {
+            return edge.weight;
+        }
+        const double offset = trip_offsets_[position];
+        const auto it = std::lower_bound(departures.begin(), departures.end(), entry_time - offset);
+        if (it == departures.end()) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return std::max(0., *it + offset - entry_time);
+    }
+
+    // Время пути от первой остановки рейса до каждой позиции маршрута
+    void TransportRouter::ComputeTripOffsets() {
+        trip_offsets_.assign(position_buses_.size(), 0.);
+        size_t position = 0;
+        size_t segment = 0;
+        for (const auto* bus : buses_) {
+            for (size_t stop = 0; stop < bus->stops.size(); ++stop, ++position) {
+                if (stop > 0) {
+                    trip_offsets_[position] = trip_offsets_[position - 1] + graph_.GetEdge(ride_edges_[segment++]).weight;
+                }
             }
-            else { 
-                // Автобус
-                const RouteInternalInfo& edge_info = edge_to_info_.at(id);
-                route.records.emplace_back(RouteInfo{
-                    .is_bus = true,
-                    .name = edge_info.bus_name,
-                    .span_count = static_cast<int>(edge_info.end_id - edge_info.start_id),
-                    .time = route_edge.weight
-                });
+        }
+    }
+
+    // Если задан момент отправления, ожидания берутся по расписанию, иначе — по весам рёбер
+    RoutingResult TransportRouter::MakeRoutingResult(const graph::Router<double>::RouteInfo& route_info,
+                                                     std::optional<double> departure_time) const {
+        RoutingResult route{};
+        route.travel_time = route_info.weight;
+        double time = departure_time.value_or(0.);
+
+        // Подряд идущие перегоны одного автобуса сворачиваются в один элемент Bus
+        bool on_board = false;
+        for (const auto id : route_info.edges) {
+            const EdgeInfo& edge_info = edges_info_[id];
+            const double weight = departure_time ? GetEdgeTravelTime(id, time) : graph_.GetEdge(id).weight;
+            time += weight;
+            switch (edge_info.type) {
+                case EdgeType::WAIT:
+                    route.records.emplace_back(RouteInfo{
+                        .is_bus = false,
+                        .name = std::string(stops_[edge_info.id]->stop_name),
+                        .span_count = 0,
+                        .time = weight
+                    });
+                    on_board = false;
+                    break;
+                case EdgeType::RIDE:
+                    if (!on_board) {
+                        route.records.emplace_back(RouteInfo{
+                            .is_bus = true,
+                            .name = std::string(buses_[edge_info.id]->bus_name),
+                            .span_count = 0,
+                            .time = 0.
+                        });
+                        on_board = true;
+                    }
+                    ++route.records.back().span_count;
+                    route.records.back().time += weight;
+                    break;
+                case EdgeType::ALIGHT:
+                    on_board = false;
+                    break;
             }
         }
         return route;
@@ -57,58 +321,95 @@ namespace router {
 
     // Создаёт граф на основе данных справочника
     void TransportRouter::BuildGraph() {
-        size_t vertex_id = 0;
+        const auto stops = catalogue_.GetAllStopsWithBus();
+        const auto buses = catalogue_.GetAllBuses();
 
-        for (const auto* stop : catalogue_.GetAllStopsWithBus()) {
+        size_t vertex_count = stops.size();
+        for (const auto* bus : buses) {
+            vertex_count += bus->stops.size();
+        }
+        graph_ = graph::DirectedWeightedGraph<double>(vertex_count);
+        vertex_coordinates_.resize(vertex_count);
+        stops_.assign(stops.begin(), stops.end());
+        buses_.assign(buses.begin(), buses.end());
 
-            vertex_to_stop_[vertex_id] = stop->stop_name;
-            stop_to_vertex_[stop->stop_name] = vertex_id;
+        for (graph::VertexId vertex_id = 0; vertex_id < stops_.size(); ++vertex_id) {
+            stop_to_vertex_[stops_[vertex_id]->stop_name] = vertex_id;
+            vertex_coordinates_[vertex_id] = stops_[vertex_id]->coordinates;
+        }
 
-            graph_.AddEdge({
-                .from = vertex_id,
-                .to = vertex_id + 1,
-                .weight = static_cast<double>(settings_.bus_wait_time)
-            });
-            vertex_id += 2;
+        graph::VertexId first_vertex = stops_.size();
+        for (uint32_t bus_id = 0; bus_id < buses_.size(); ++bus_id) {
+            AddBusEdges(*buses_[bus_id], bus_id, first_vertex);
+            first_vertex += buses_[bus_id]->stops.size();
         }
+        graph_.Finalize();
+        ComputeTripOffsets();
+    }
 
-        for (const auto* bus : catalogue_.GetAllBuses()) {
-            AddBusEdges(*bus);
-        }    
+    // Вершины позиций маршрута занимают номера [first_vertex, first_vertex + stops.size())
+    void TransportRouter::AddBusEdges(const domain::Bus& bus, uint32_t bus_id, graph::VertexId first_vertex) {
+        const auto& stops = bus.stops;
+
+        for (size_t position = 0; position < stops.size(); ++position) {
+            position_buses_.push_back(bus_id);
+            const domain::Stop& stop = catalogue_.GetStop(stops[position]);
+            const graph::VertexId stop_vertex = stop_to_vertex_.at(stop.stop_name);
+            const graph::VertexId bus_vertex = first_vertex + position;
+            vertex_coordinates_[bus_vertex] = stop.coordinates;
+
+            if (position > 0) {
+                AddEdge(bus_vertex, stop_vertex, 0., EdgeInfo{EdgeType::ALIGHT, bus_id});
+            }
+            if (position + 1 < stops.size()) {
+                AddEdge(stop_vertex, bus_vertex, static_cast<double>(settings_.bus_wait_time),
+                        EdgeInfo{EdgeType::WAIT, static_cast<uint32_t>(stop_vertex)});
+
+                ride_edges_.push_back(AddEdge(bus_vertex, bus_vertex + 1, GetSegmentTime(bus, position),
+                                              EdgeInfo{EdgeType::RIDE, bus_id}));
+            }
+        }
     }
 
-    void TransportRouter::AddBusEdges(const domain::Bus& bus) {
+    // Время перегона от позиции position маршрута до следующей, в минутах
+    double TransportRouter::GetSegmentTime(const domain::Bus& bus, size_t position) const {
         const double velocity_mps = settings_.bus_velocity * 1000.0 / 60.0;
-        const auto& stops = bus.stops;
+        const double segment_distance = bus.distances[position];
+        return segment_distance / velocity_mps;
+    }
 
-        size_t stop_count = stops.size();
-    
-        if (stop_count < 2) return;
-        
-        // start - начальная остановка
-        for (size_t start = 0; start < stop_count - 1; ++start) { 
-            // Накопленное время
-            double accumulated_travel_time = 0.0;
-            // end - конечная остановка
-            for (size_t end = start + 1; end < stop_count; ++end) { 
-                double segment_distance = catalogue_.GetStopDistance(stops[end - 1], stops[end]);
-                double segment_travel_time = segment_distance / velocity_mps;
-    
-                accumulated_travel_time += segment_travel_time;
-
-                graph::EdgeId edge_id = graph_.AddEdge({
-                    .from = stop_to_vertex_.at(stops[start]->stop_name) + 1, 
-                    .to = stop_to_vertex_.at(stops[end]->stop_name), 
-                    .weight = accumulated_travel_time
-                });
-
-                edge_to_info_[edge_id] = RouteInternalInfo{
-                    .start_id = start,
-                    .end_id = end,
-                    .bus_name = bus.bus_name
-                };
-    
+    graph::EdgeId TransportRouter::AddEdge(graph::VertexId from, graph::VertexId to, double weight, EdgeInfo info) {
+        const graph::EdgeId edge_id = graph_.AddEdge({
+            .from = from,
+            .to = to,
+            .weight = weight
+        });
+        edges_info_.push_back(info);
+        return edge_id;
+    }
+
+    // Наибольшая скорость сближения по прямой на перегонах всех маршрутов, в метрах в минуту.
+    // Дорожное расстояние в справочнике может быть короче геодезического, поэтому скорость
+    // берётся не из настроек, а по фактическим перегонам: так оценка остаётся допустимой.
+    // Возвращает 0, если оценку построить нельзя (перегон нулевой длины между разными точками).
+    double TransportRouter::GetHeuristicSpeed() const {
+        const double velocity_mpm = settings_.bus_velocity * 1000.0 / 60.0;
+        double max_speed = velocity_mpm;
+        for (const auto* bus : catalogue_.GetAllBuses()) {
+            for (size_t stop = 0; stop + 1 < bus->stops.size(); ++stop) {
+                const double geo_distance = GreatCircleDistance(catalogue_.GetStop(bus->stops[stop]).coordinates,
+                                                                catalogue_.GetStop(bus->stops[stop + 1]).coordinates);
+                const int road_distance = bus->distances[stop];
+                if (geo_distance <= 0.) {
+                    continue;
+                }
+                if (road_distance <= 0) {
+                    return 0.;
+                }
+                max_speed = std::max(max_speed, velocity_mpm * geo_distance / road_distance);
             }
         }
+        // Запас на погрешность вычислений с плавающей точкой
+        return max_speed * (1. + 1e-9);
     }
 } // namespace router
\ No newline at end of file
@@ -1,15 +1,21 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include "transport_catalogue.h"
 #include "graph.h"
+#include "raptor.h"
 #include "router.h"
 
 namespace router {
     struct Settings {
         double bus_velocity;
         int bus_wait_time;
+        graph::RouterMode router_mode = graph::RouterMode::DIJKSTRA;
+        // Потоки для предрасчёта маршрутизатора, 0 — по числу ядер
+        size_t preprocessing_threads = 1;
     };
 
     struct RouteInfo {
@@ -24,28 +30,90 @@ namespace router {
         std::vector<RouteInfo> records;
     };
 
-    
-    struct RouteInternalInfo {
-        size_t start_id;
-        size_t end_id;
-        std::string bus_name;
+    // Граф строится по схеме «шаблон маршрута»: у каждой остановки одна вершина, у каждой
+    // позиции остановки в маршруте автобуса — своя вершина «в автобусе». Поездка — цепочка
+    // рёбер между соседними позициями, поэтому число пересечённых остановок не хранится,
+    // а считается по рёбрам пути.
+    enum class EdgeType : uint8_t {
+        WAIT,   // посадка: остановка -> позиция маршрута, вес — время ожидания
+        RIDE,   // перегон между соседними позициями маршрута
+        ALIGHT  // высадка: позиция маршрута -> остановка, вес 0
     };
 
+    struct EdgeInfo {
+        EdgeType type;
+        // Номер остановки для WAIT, номер автобуса для RIDE
+        uint32_t id;
+    };
+
+    // Построенный маршрутизатор только читается: константные методы не меняют состояния и могут
+    // вызываться из нескольких потоков одновременно, если справочник в это время не меняется.
+    // Исключение — данные RAPTOR: они строятся один раз при первом запросе по Парето под std::call_once.
+    // UpdateSettings и UpdateStopDistance требуют, чтобы в это время никто не строил маршруты
     class TransportRouter {
     public:
         TransportRouter(const transport_catalogue::TransportCatalogue& catalogue, router::Settings settings);
         std::optional<RoutingResult> BuildRoute(std::string_view from, std::string_view to) const;
+        // Самый быстрый маршрут при отправлении в departure_time (минуты от начала суток) с учётом
+        // расписаний автобусов; travel_time — время от отправления до прибытия, включая первое ожидание
+        std::optional<RoutingResult> BuildRouteDepartingAt(std::string_view from, std::string_view to,
+                                                           double departure_time) const;
+        // Самый быстрый маршрут не более чем с max_transfers пересадками
+        std::optional<RoutingResult> BuildRoute(std::string_view from, std::string_view to, size_t max_transfers) const;
+        // Маршруты, оптимальные по Парето по времени и числу пересадок, по возрастанию числа пересадок
+        std::vector<RoutingResult> BuildParetoRoutes(std::string_view from, std::string_view to,
+                                                     std::optional<size_t> max_transfers = std::nullopt) const;
+        // Время в пути из каждой остановки from в каждую остановку to: по одному поиску на строку.
+        // std::nullopt — остановки нет или пути нет
+        std::vector<std::vector<std::optional<double>>> ComputeTravelTimes(const std::vector<std::string_view>& from,
+                                                                           const std::vector<std::string_view>& to) const;
+        // Остановки, до которых из from можно добраться не дольше max_time, по возрастанию времени
+        std::optional<std::vector<std::pair<std::string_view, double>>> ComputeIsochrone(std::string_view from,
+                                                                                         double max_time) const;
+
+        // Меняет скорость автобусов и время ожидания без перестройки графа: веса рёбер
+        // пересчитываются на месте, маршрутизатор чинит только затронутые данные
+        void UpdateSettings(double bus_velocity, int bus_wait_time);
+        // Перечитывает из справочника расстояние между остановками from и to (в обе стороны)
+        // и обновляет веса перегонов между ними
+        void UpdateStopDistance(std::string_view from, std::string_view to);
 
     private:
         void BuildGraph();
-        void AddBusEdges(const domain::Bus& bus);
+        void AddBusEdges(const domain::Bus& bus, uint32_t bus_id, graph::VertexId first_vertex);
+        graph::EdgeId AddEdge(graph::VertexId from, graph::VertexId to, double weight, EdgeInfo info);
+        double GetSegmentTime(const domain::Bus& bus, size_t position) const;
+        void SetEdgeWeight(graph::EdgeId edge_id, double weight,
+                           std::vector<graph::Router<double>::EdgeWeightChange>& changes);
+        void ApplyWeightChanges(const std::vector<graph::Router<double>::EdgeWeightChange>& changes);
+        graph::Router<double>::Heuristic MakeHeuristic() const;
+        const RaptorRouter& GetRaptor() const;
+        double GetHeuristicSpeed() const;
+        RoutingResult MakeRoutingResult(const RaptorJourney& journey) const;
+        RoutingResult MakeRoutingResult(const graph::Router<double>::RouteInfo& route_info,
+                                        std::optional<double> departure_time) const;
+        double GetEdgeTravelTime(graph::EdgeId edge_id, double entry_time) const;
+        void ComputeTripOffsets();
         const transport_catalogue::TransportCatalogue& catalogue_;
         router::Settings settings_;
         graph::DirectedWeightedGraph<double> graph_;
         std::unique_ptr<graph::Router<double>> router_;
+        // Нужен только запросам с пересадками и по Парето, поэтому строится при первом таком запросе
+        mutable std::once_flag raptor_built_;
+        mutable std::unique_ptr<RaptorRouter> raptor_;
         std::unordered_map<std::string_view, graph::VertexId> stop_to_vertex_;
-        std::unordered_map<graph::VertexId, std::string_view> vertex_to_stop_;
-        std::unordered_map<graph::EdgeId, RouteInternalInfo> edge_to_info_;
+        // Вершины остановок идут первыми, их номера совпадают с номерами в stops_
+        std::vector<const domain::Stop*> stops_;
+        std::vector<const domain::Bus*> buses_;
+        std::vector<geo::Coordinates> vertex_coordinates_;
+        // Сведения о рёбрах, индекс — EdgeId
+        std::vector<EdgeInfo> edges_info_;
+        // Рёбра RIDE в порядке автобусов и позиций маршрутов
+        std::vector<graph::EdgeId> ride_edges_;
+        // Номер автобуса и время пути рейса от первой остановки для каждой позиции маршрута;
+        // вершина позиции — stops_.size() + индекс
+        std::vector<uint32_t> position_buses_;
+        std::vector<double> trip_offsets_;
 
     };
 } // namespace router
\ No newline at end of file